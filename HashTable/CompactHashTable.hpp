@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file CompactHashTable.hpp
+ * @brief Insertion-ordered hash table implementation of a key/value
+ * dictionary, in the compact layout of Python's dict: entries are kept in a
+ * dense array in the order they were inserted, and a separate index array of
+ * 8, 16, 32 or 64 bit entry numbers is probed to find them.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef COMPACTHASHTABLE_H
+#define COMPACTHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "./HashFunctions.hpp"
+
+template<typename KEY_TYPE, typename VALUE_TYPE>
+struct CompactHashTableEntry
+{
+    KEY_TYPE key;
+    VALUE_TYPE value;
+};
+
+// The index array is a power of two number of slots, each holding the number
+// of an entry, or a marker for an empty slot or a removed entry. Slots are
+// as narrow as the number of entries allows, so a table of up to 254 entries
+// spends one byte per slot. The entry array holds two thirds as many entries
+// as there are slots, which keeps probe sequences short without spending a
+// whole entry on each empty slot.
+//
+// New entries are appended to the entry array. Removing an entry leaves a
+// hole that is skipped by iteration and closed when the entry array is next
+// rebuilt, so iteration always visits entries in insertion order, and reads
+// the entry array from front to back. Overwriting a value keeps the entry's
+// place in the order.
+//
+// Pointers returned by get() are invalidated by any insert that rebuilds
+// the entry array.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class CompactHashTable
+{
+    public:
+        // Constructor. The table holds at least tableSize elements before its
+        // arrays are rebuilt.
+        CompactHashTable(size_t tableSize = 8, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            allocateArrays(indexCapacityFor(tableSize));
+        }
+
+        CompactHashTable(const CompactHashTable&) = delete;
+        CompactHashTable& operator=(const CompactHashTable&) = delete;
+
+        // Destructor
+        ~CompactHashTable()
+        {
+            clear();
+            deallocateArrays();
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        // Algorithmic runtime: O(1) amortized
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            size_t hash = hashOf(key);
+            size_t slot;
+            if (findSlot(key, hash, slot))
+            {
+                entries[indexAt(slot)].value = value;
+                return;
+            }
+
+            // The key does not exist; rebuild the arrays first if the entry array is full
+            if (usedEntries == entryCapacity) rebuild(numberOfElements + 1);
+            new (&entries[usedEntries]) CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>{key, value};
+            entryHashes[usedEntries] = hash;
+            setIndex(findFreeSlot(hash), usedEntries);
+            usedEntries++;
+            numberOfElements++;
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        // Algorithmic runtime: O(1) expected
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t slot;
+            if (!findSlot(key, hashOf(key), slot)) return false;
+
+            // Leave a hole in the entry array, and a marker in the index array
+            // so that probe sequences passing through the slot are not cut short
+            size_t entry = indexAt(slot);
+            entries[entry].~CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>();
+            entryHashes[entry] = REMOVED_HASH;
+            setIndex(slot, REMOVED_INDEX);
+            numberOfElements--;
+            return true;
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1) expected
+        VALUE_TYPE* get(const KEY_TYPE& key)
+        {
+            size_t slot;
+            if (findSlot(key, hashOf(key), slot)) return &entries[indexAt(slot)].value;
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1) expected
+        bool contains(const KEY_TYPE& key)
+        {
+            size_t slot;
+            return findSlot(key, hashOf(key), slot);
+        }
+
+        // Clears all elements from the table. Does not shrink the arrays.
+        // Algorithmic runtime: O(N + slots)
+        void clear()
+        {
+            for (size_t i = 0; i < usedEntries; i++)
+            {
+                if (entryHashes[i] != REMOVED_HASH) entries[i].~CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>();
+            }
+            std::memset(indices, 0xFF, indexCapacity * indexWidth);
+            usedEntries = 0;
+            numberOfElements = 0;
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Calls visit(key, value) for every element, in insertion order
+        // Algorithmic runtime: O(N + removed entries not yet closed up)
+        template<typename VISIT_FUNCTION>
+        void forEach(VISIT_FUNCTION visit)
+        {
+            for (size_t i = 0; i < usedEntries; i++)
+            {
+                if (entryHashes[i] != REMOVED_HASH) visit(static_cast<const KEY_TYPE&>(entries[i].key), entries[i].value);
+            }
+        }
+
+        template<typename VISIT_FUNCTION>
+        void forEach(VISIT_FUNCTION visit) const
+        {
+            for (size_t i = 0; i < usedEntries; i++)
+            {
+                if (entryHashes[i] != REMOVED_HASH) visit(static_cast<const KEY_TYPE&>(entries[i].key), static_cast<const VALUE_TYPE&>(entries[i].value));
+            }
+        }
+
+        // Prints the contents of the table to an output stream (the console by default), in insertion order
+        void print(std::ostream& outputStream = std::cout) const
+        {
+            forEach([&](const KEY_TYPE& key, const VALUE_TYPE& value)
+            {
+                outputStream << key << ": " << value << std::endl;
+            });
+        }
+
+        // Returns the number of slots in the index array
+        size_t bucketCount() const
+        {
+            return indexCapacity;
+        }
+
+        // Returns the number of bytes used by the index array
+        size_t indexBytes() const
+        {
+            return indexCapacity * indexWidth;
+        }
+
+        // Rebuilds the arrays so that they can hold at least the given number
+        // of elements
+        void reserve(size_t elementCount)
+        {
+            if (elementCount > entryCapacity) rebuild(elementCount);
+        }
+
+    private:
+        // Index array markers for an empty slot and for a removed entry,
+        // truncated to the width of a slot
+        static constexpr size_t EMPTY_INDEX = SIZE_MAX;
+        static constexpr size_t REMOVED_INDEX = SIZE_MAX - 1;
+
+        // The hash stored for a removed entry; no key is given this hash
+        static constexpr size_t REMOVED_HASH = SIZE_MAX;
+
+        // The entry array, in insertion order, and the hash of each entry
+        CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>* entries;
+        size_t* entryHashes;
+        std::allocator<CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>> entryAllocator;
+
+        // The number of entries the entry array holds, and the number used so
+        // far, including removed entries
+        size_t entryCapacity;
+        size_t usedEntries = 0;
+
+        // The index array, its number of slots (a power of two), and the
+        // number of bytes in each slot
+        unsigned char* indices;
+        size_t indexCapacity;
+        size_t indexWidth;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The number of elements in the table
+        size_t numberOfElements = 0;
+
+        // Returns the smallest index array that holds the given number of entries
+        static size_t indexCapacityFor(size_t elementCount)
+        {
+            size_t capacity = 8;
+            while (capacity / 3 * 2 < elementCount) capacity *= 2;
+            return capacity;
+        }
+
+        // Returns the narrowest slot that can hold every entry number and both markers
+        static size_t indexWidthFor(size_t entryCount)
+        {
+            if (entryCount <= UINT8_MAX - 1) return 1;
+            if (entryCount <= UINT16_MAX - 1) return 2;
+            if (entryCount <= UINT32_MAX - 1) return 4;
+            return 8;
+        }
+
+        size_t hashOf(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            return hash == REMOVED_HASH ? REMOVED_HASH - 1 : hash;
+        }
+
+        template<typename INDEX_TYPE>
+        static size_t readIndex(const unsigned char* indices, size_t slot)
+        {
+            INDEX_TYPE index;
+            std::memcpy(&index, indices + slot * sizeof(INDEX_TYPE), sizeof(INDEX_TYPE));
+            if (index == (INDEX_TYPE)EMPTY_INDEX) return EMPTY_INDEX;
+            if (index == (INDEX_TYPE)REMOVED_INDEX) return REMOVED_INDEX;
+            return index;
+        }
+
+        template<typename INDEX_TYPE>
+        static void writeIndex(unsigned char* indices, size_t slot, size_t index)
+        {
+            INDEX_TYPE narrowed = (INDEX_TYPE)index;
+            std::memcpy(indices + slot * sizeof(INDEX_TYPE), &narrowed, sizeof(INDEX_TYPE));
+        }
+
+        // Returns the entry number in a slot, or one of the markers
+        size_t indexAt(size_t slot) const
+        {
+            switch (indexWidth)
+            {
+                case 1: return readIndex<uint8_t>(indices, slot);
+                case 2: return readIndex<uint16_t>(indices, slot);
+                case 4: return readIndex<uint32_t>(indices, slot);
+                default: return readIndex<uint64_t>(indices, slot);
+            }
+        }
+
+        void setIndex(size_t slot, size_t index)
+        {
+            switch (indexWidth)
+            {
+                case 1: writeIndex<uint8_t>(indices, slot, index); break;
+                case 2: writeIndex<uint16_t>(indices, slot, index); break;
+                case 4: writeIndex<uint32_t>(indices, slot, index); break;
+                default: writeIndex<uint64_t>(indices, slot, index); break;
+            }
+        }
+
+        // Steps through the probe sequence of a hash. The higher bits of the
+        // hash are shifted into the sequence a few at a time, so keys that
+        // share their low bits soon take different paths (as in CPython).
+        void nextSlot(size_t& slot, size_t& perturb) const
+        {
+            perturb >>= 5;
+            slot = (slot * 5 + perturb + 1) & (indexCapacity - 1);
+        }
+
+        // Finds the slot holding the key, returning false if there is none
+        bool findSlot(const KEY_TYPE& key, size_t hash, size_t& slot) const
+        {
+            slot = hash & (indexCapacity - 1);
+            size_t perturb = hash;
+            while (true)
+            {
+                size_t index = indexAt(slot);
+                if (index == EMPTY_INDEX) return false;
+                if (index != REMOVED_INDEX && entryHashes[index] == hash && keyEqual(entries[index].key, key)) return true;
+                nextSlot(slot, perturb);
+            }
+        }
+
+        // Finds the first slot in the probe sequence of a hash that holds no entry
+        size_t findFreeSlot(size_t hash) const
+        {
+            size_t slot = hash & (indexCapacity - 1);
+            size_t perturb = hash;
+            while (indexAt(slot) < REMOVED_INDEX) nextSlot(slot, perturb);
+            return slot;
+        }
+
+        // Allocates empty arrays for the given number of index slots. Only
+        // replaces the current arrays once every allocation has succeeded.
+        void allocateArrays(size_t newIndexCapacity)
+        {
+            size_t newEntryCapacity = newIndexCapacity / 3 * 2;
+            size_t newIndexWidth = indexWidthFor(newEntryCapacity);
+            CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>* newEntries = entryAllocator.allocate(newEntryCapacity);
+            size_t* newEntryHashes = nullptr;
+            unsigned char* newIndices;
+            try
+            {
+                newEntryHashes = new size_t[newEntryCapacity];
+                newIndices = new unsigned char[newIndexCapacity * newIndexWidth];
+            }
+            catch (...)
+            {
+                delete[] newEntryHashes;
+                entryAllocator.deallocate(newEntries, newEntryCapacity);
+                throw;
+            }
+            std::memset(newIndices, 0xFF, newIndexCapacity * newIndexWidth);
+            entries = newEntries;
+            indices = newIndices;
+            entryHashes = newEntryHashes;
+            entryCapacity = newEntryCapacity;
+            indexCapacity = newIndexCapacity;
+            indexWidth = newIndexWidth;
+        }
+
+        void deallocateArrays()
+        {
+            entryAllocator.deallocate(entries, entryCapacity);
+            delete[] entryHashes;
+            delete[] indices;
+        }
+
+        // Moves every element, in order, into new arrays sized for at least
+        // minimumElements and for twice the current number of elements,
+        // closing up the holes left by removed entries. Elements whose move
+        // could throw are copied, so the table is unchanged if it throws.
+        // Algorithmic runtime: O(N + removed entries)
+        void rebuild(size_t minimumElements)
+        {
+            size_t requiredElements = numberOfElements * 2 > minimumElements ? numberOfElements * 2 : minimumElements;
+            CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>* oldEntries = entries;
+            size_t* oldEntryHashes = entryHashes;
+            unsigned char* oldIndices = indices;
+            size_t oldEntryCapacity = entryCapacity;
+            size_t oldIndexCapacity = indexCapacity;
+            size_t oldIndexWidth = indexWidth;
+            size_t oldUsedEntries = usedEntries;
+            allocateArrays(indexCapacityFor(requiredElements));
+
+            usedEntries = 0;
+            try
+            {
+                for (size_t i = 0; i < oldUsedEntries; i++)
+                {
+                    if (oldEntryHashes[i] == REMOVED_HASH) continue;
+                    new (&entries[usedEntries]) CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>(std::move_if_noexcept(oldEntries[i]));
+                    entryHashes[usedEntries] = oldEntryHashes[i];
+                    setIndex(findFreeSlot(oldEntryHashes[i]), usedEntries);
+                    usedEntries++;
+                }
+            }
+            catch (...)
+            {
+                for (size_t i = 0; i < usedEntries; i++) entries[i].~CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>();
+                deallocateArrays();
+                entries = oldEntries;
+                entryHashes = oldEntryHashes;
+                indices = oldIndices;
+                entryCapacity = oldEntryCapacity;
+                indexCapacity = oldIndexCapacity;
+                indexWidth = oldIndexWidth;
+                usedEntries = oldUsedEntries;
+                throw;
+            }
+
+            for (size_t i = 0; i < oldUsedEntries; i++)
+            {
+                if (oldEntryHashes[i] != REMOVED_HASH) oldEntries[i].~CompactHashTableEntry<KEY_TYPE, VALUE_TYPE>();
+            }
+            entryAllocator.deallocate(oldEntries, oldEntryCapacity);
+            delete[] oldEntryHashes;
+            delete[] oldIndices;
+        }
+};
+
+#endif
@@ -0,0 +1,307 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file ConcurrentHashTable.hpp
+ * @brief Thread-safe hash table implementation of a key/value dictionary. Uses
+ * linked lists to handle collisions and an array of reader-writer lock stripes
+ * to guard the buckets.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef CONCURRENTHASHTABLE_H
+#define CONCURRENTHASHTABLE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include "./HashFunctions.hpp"
+#include "./HashTable.hpp"
+
+// Every bucket is guarded by one of a fixed number of lock stripes. The
+// number of buckets is always a multiple of the number of stripes, so the
+// stripe of a key depends only on its hash and does not change when the
+// table grows. Lookups take their stripe's lock shared and updates take it
+// exclusively, so threads only contend when they touch the same stripe.
+// Growing the table takes every stripe exclusively, in order.
+//
+// Values are returned by copy, since another thread may overwrite or remove
+// an entry as soon as its stripe is unlocked.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class ConcurrentHashTable
+{
+    public:
+        // Constructor. Both the table size and the stripe count are rounded
+        // up to powers of two, and the table grows once the load factor of
+        // any stripe would exceed maxLoadFactor.
+        ConcurrentHashTable(size_t tableSize = 128, size_t stripeCount = 64, float maxLoadFactor = 1.0f, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            if (!(maxLoadFactor > 0)) throw std::invalid_argument("The maximum load factor must be greater than zero");
+            this->maxLoadFactor = maxLoadFactor;
+            this->stripeCount = roundUpToPowerOfTwo(stripeCount, 1);
+            this->stripes = new Stripe[this->stripeCount];
+            this->tableArrayCapacity = roundUpToPowerOfTwo(tableSize, this->stripeCount);
+            this->table = allocateTableArray(this->tableArrayCapacity);
+        }
+
+        ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+        ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+        // Destructor. No other thread may be using the table.
+        ~ConcurrentHashTable()
+        {
+            clear();
+            std::free(table);
+            delete[] stripes;
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            size_t hash = hasher(key);
+            Stripe& stripe = stripeFor(hash);
+            bool needsToGrow;
+            {
+                std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+                HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucket = table[hash & (tableArrayCapacity - 1)];
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findInChain(bucket, key, hash);
+                if (node != nullptr)
+                {
+                    node->value = value;
+                    return;
+                }
+                bucket = new HashTableNode<KEY_TYPE, VALUE_TYPE>{key, value, bucket, hash};
+                size_t stripeElements = stripe.numberOfElements.load(std::memory_order_relaxed) + 1;
+                stripe.numberOfElements.store(stripeElements, std::memory_order_relaxed);
+                needsToGrow = isOverloaded(stripeElements);
+            }
+            if (needsToGrow) grow();
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t hash = hasher(key);
+            Stripe& stripe = stripeFor(hash);
+            std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+
+            HashTableNode<KEY_TYPE, VALUE_TYPE>** link = &table[hash & (tableArrayCapacity - 1)];
+            while (*link != nullptr)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* current = *link;
+                if (current->hash == hash && keyEqual(current->key, key))
+                {
+                    *link = current->next;
+                    delete current;
+                    stripe.numberOfElements.store(stripe.numberOfElements.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                    return true;
+                }
+                link = &current->next;
+            }
+            return false;
+        }
+
+        // Returns a copy of the value associated with the key, or nothing if the key does not exist
+        std::optional<VALUE_TYPE> get(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            Stripe& stripe = stripeFor(hash);
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findInChain(table[hash & (tableArrayCapacity - 1)], key, hash);
+            if (node != nullptr) return node->value;
+            return std::nullopt;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        bool contains(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            Stripe& stripe = stripeFor(hash);
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            return findInChain(table[hash & (tableArrayCapacity - 1)], key, hash) != nullptr;
+        }
+
+        // Calls update(value) on the value associated with the key while its
+        // stripe is locked, so that read-modify-write updates are atomic.
+        // Returns false if the key does not exist.
+        template<typename UPDATE_FUNCTION>
+        bool update(const KEY_TYPE& key, UPDATE_FUNCTION update)
+        {
+            size_t hash = hasher(key);
+            Stripe& stripe = stripeFor(hash);
+            std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findInChain(table[hash & (tableArrayCapacity - 1)], key, hash);
+            if (node == nullptr) return false;
+            update(node->value);
+            return true;
+        }
+
+        // Clears all elements from the table, freeing the associated memory.
+        void clear()
+        {
+            AllStripesLock lock(*this);
+            for (size_t i = 0; i < tableArrayCapacity; i++)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[i];
+                while (current != nullptr)
+                {
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* next = current->next;
+                    delete current;
+                    current = next;
+                }
+                table[i] = nullptr;
+            }
+            for (size_t i = 0; i < stripeCount; i++) stripes[i].numberOfElements.store(0, std::memory_order_relaxed);
+        }
+
+        // Returns the number of elements in the table. While other threads are
+        // modifying the table this is only a snapshot.
+        size_t size() const
+        {
+            size_t numberOfElements = 0;
+            for (size_t i = 0; i < stripeCount; i++) numberOfElements += stripes[i].numberOfElements.load(std::memory_order_relaxed);
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Returns the number of buckets in the table array
+        size_t bucketCount() const
+        {
+            AllStripesLock lock(*this, true);
+            return tableArrayCapacity;
+        }
+
+    private:
+        // A lock stripe and the number of elements in the buckets it guards.
+        // Each stripe sits on its own cache line so that threads locking
+        // different stripes do not slow each other down.
+        struct alignas(64) Stripe
+        {
+            mutable std::shared_mutex mutex;
+            std::atomic<size_t> numberOfElements{0};
+        };
+
+        // Locks every stripe, in order, for the lifetime of the object
+        class AllStripesLock
+        {
+            public:
+                AllStripesLock(const ConcurrentHashTable& hashTable, bool shared = false)
+                    : hashTable(hashTable), shared(shared)
+                {
+                    for (size_t i = 0; i < hashTable.stripeCount; i++)
+                    {
+                        if (shared) hashTable.stripes[i].mutex.lock_shared();
+                        else hashTable.stripes[i].mutex.lock();
+                    }
+                }
+
+                ~AllStripesLock()
+                {
+                    for (size_t i = hashTable.stripeCount; i > 0; i--)
+                    {
+                        if (shared) hashTable.stripes[i - 1].mutex.unlock_shared();
+                        else hashTable.stripes[i - 1].mutex.unlock();
+                    }
+                }
+
+            private:
+                const ConcurrentHashTable& hashTable;
+                bool shared;
+        };
+
+        // The hash table array and its size (a power of two, and a multiple
+        // of the stripe count). Only changed while every stripe is locked.
+        HashTableNode<KEY_TYPE, VALUE_TYPE>** table;
+        size_t tableArrayCapacity;
+
+        // The lock stripes
+        Stripe* stripes;
+        size_t stripeCount;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The load factor past which the table array grows
+        float maxLoadFactor;
+
+        static size_t roundUpToPowerOfTwo(size_t value, size_t minimum)
+        {
+            size_t powerOfTwo = minimum;
+            while (powerOfTwo < value) powerOfTwo *= 2;
+            return powerOfTwo;
+        }
+
+        static HashTableNode<KEY_TYPE, VALUE_TYPE>** allocateTableArray(size_t capacity)
+        {
+            void* tableArray = std::calloc(capacity, sizeof(HashTableNode<KEY_TYPE, VALUE_TYPE>*));
+            if (tableArray == nullptr) throw std::bad_alloc();
+            return static_cast<HashTableNode<KEY_TYPE, VALUE_TYPE>**>(tableArray);
+        }
+
+        Stripe& stripeFor(size_t hash) const
+        {
+            return stripes[hash & (stripeCount - 1)];
+        }
+
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* findInChain(HashTableNode<KEY_TYPE, VALUE_TYPE>* current, const KEY_TYPE& key, size_t hash) const
+        {
+            while (current != nullptr)
+            {
+                if (current->hash == hash && keyEqual(current->key, key)) return current;
+                current = current->next;
+            }
+            return nullptr;
+        }
+
+        // Returns true if a stripe holding the given number of elements has
+        // pushed the load factor of its buckets past the maximum
+        bool isOverloaded(size_t stripeElements) const
+        {
+            return stripeElements > (tableArrayCapacity / stripeCount) * maxLoadFactor;
+        }
+
+        // Doubles the size of the table array while holding every stripe
+        void grow()
+        {
+            AllStripesLock lock(*this);
+
+            // Another thread may have grown the table while this one waited
+            bool overloaded = false;
+            for (size_t i = 0; i < stripeCount && !overloaded; i++) overloaded = isOverloaded(stripes[i].numberOfElements.load(std::memory_order_relaxed));
+            if (!overloaded) return;
+
+            // Move every node into its bucket in the new table array
+            size_t newCapacity = tableArrayCapacity * 2;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>** newTable = allocateTableArray(newCapacity);
+            for (size_t i = 0; i < tableArrayCapacity; i++)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[i];
+                while (current != nullptr)
+                {
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* next = current->next;
+                    size_t bucket = current->hash & (newCapacity - 1);
+                    current->next = newTable[bucket];
+                    newTable[bucket] = current;
+                    current = next;
+                }
+            }
+            std::free(table);
+            table = newTable;
+            tableArrayCapacity = newCapacity;
+        }
+};
+
+#endif
@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file CuckooHashTable.hpp
+ * @brief Bucketized cuckoo hash table implementation of a key/value
+ * dictionary. Every key can live in one of four slots in each of two
+ * buckets, so a lookup never examines more than two buckets.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef CUCKOOHASHTABLE_H
+#define CUCKOOHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "./HashFunctions.hpp"
+
+template<typename KEY_TYPE, typename VALUE_TYPE>
+struct CuckooHashTableSlot
+{
+    KEY_TYPE key;
+    VALUE_TYPE value;
+};
+
+// A key's first bucket comes from its hash, and its second bucket is the
+// first one XORed with a scramble of an 8-bit tag taken from the top of the
+// hash (partial-key cuckoo hashing). Either bucket can therefore be computed
+// from the other and the tag alone, so entries are moved between buckets
+// without hashing their keys again.
+//
+// Each bucket holds four tags followed by four slots and is aligned to a cache
+// line; when a key and value together take at most 15 bytes, a bucket fits in
+// one cache line and a get() or contains() touches at most two. Keys are only
+// compared for slots whose tag matches.
+//
+// When both of a new key's buckets are full, a breadth-first search looks for
+// the shortest chain of entries that can each be moved to their other bucket
+// to free a slot. If there is none, the table doubles in size. Keys that share
+// a whole hash share both buckets, so no more than eight of them fit however
+// large the table grows; once placing a key fails while the table is mostly
+// empty, insert() throws std::overflow_error instead of growing without end.
+// This limit is inherent to cuckoo hashing. A hash that spreads keys
+// reasonably never reaches it; HashTable suits keys that cannot be hashed
+// apart.
+//
+// Pointers returned by get() are invalidated by any insert or remove, since
+// entries move between slots.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class CuckooHashTable
+{
+    public:
+        // Constructor. The number of slots is rounded up to a power of two of
+        // at least two buckets, and the table grows once the load factor would
+        // exceed maxLoadFactor.
+        CuckooHashTable(size_t tableSize = 16, float maxLoadFactor = 0.95f, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            if (!(maxLoadFactor > 0 && maxLoadFactor <= 1)) throw std::invalid_argument("The maximum load factor must be greater than zero and at most one");
+            this->maxLoadFactor = maxLoadFactor;
+            allocateBuckets(roundUpToPowerOfTwo((tableSize + SLOTS_PER_BUCKET - 1) / SLOTS_PER_BUCKET));
+        }
+
+        CuckooHashTable(const CuckooHashTable&) = delete;
+        CuckooHashTable& operator=(const CuckooHashTable&) = delete;
+
+        // Destructor
+        ~CuckooHashTable()
+        {
+            clear();
+            delete[] buckets;
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        // Throws std::overflow_error, leaving the elements unchanged, if
+        // more keys share the key's hash than its two buckets can hold.
+        // Algorithmic runtime: O(1) expected
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            size_t hash = hasher(key);
+            VALUE_TYPE* existing = findValue(key, hash);
+            if (existing != nullptr)
+            {
+                *existing = value;
+                return;
+            }
+
+            // The key does not exist; grow first if the new element would push
+            // the load factor past its maximum
+            if (numberOfElements + 1 > slotCount() * maxLoadFactor) rehash(bucketArrayCapacity * 2);
+
+            CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE> newSlot{key, value};
+            while (!place(newSlot, hash))
+            {
+                // Full buckets in a mostly empty table mean many keys share a
+                // hash, which growing will not fix
+                if (loadFactor() < 0.125f) throw std::overflow_error("Too many keys in the table share the same hash");
+                rehash(bucketArrayCapacity * 2);
+            }
+            numberOfElements++;
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        // Algorithmic runtime: O(1)
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t hash = hasher(key);
+            Bucket* bucket;
+            size_t slot;
+            if (!findSlot(key, hash, bucket, slot)) return false;
+            bucket->slot(slot).~CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            bucket->tags[slot] = EMPTY_TAG;
+            numberOfElements--;
+            return true;
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1), examining at most two buckets
+        VALUE_TYPE* get(const KEY_TYPE& key)
+        {
+            return findValue(key, hasher(key));
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1), examining at most two buckets
+        bool contains(const KEY_TYPE& key)
+        {
+            return findValue(key, hasher(key)) != nullptr;
+        }
+
+        // Clears all elements from the table. Does not shrink the bucket array.
+        // Algorithmic runtime: O(capacity)
+        void clear()
+        {
+            for (size_t i = 0; i < bucketArrayCapacity; i++)
+            {
+                for (size_t s = 0; s < SLOTS_PER_BUCKET; s++)
+                {
+                    if (buckets[i].tags[s] == EMPTY_TAG) continue;
+                    buckets[i].slot(s).~CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+                    buckets[i].tags[s] = EMPTY_TAG;
+                }
+            }
+            numberOfElements = 0;
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Prints the contents of the table to an output stream (the console by default)
+        void print(std::ostream& outputStream = std::cout)
+        {
+            for (size_t i = 0; i < bucketArrayCapacity; i++)
+            {
+                for (size_t s = 0; s < SLOTS_PER_BUCKET; s++)
+                {
+                    if (buckets[i].tags[s] == EMPTY_TAG) continue;
+                    outputStream << buckets[i].slot(s).key << ": " << buckets[i].slot(s).value << std::endl;
+                }
+            }
+        }
+
+        // Returns the number of buckets in the table. Each bucket holds up to
+        // four elements.
+        size_t bucketCount() const
+        {
+            return bucketArrayCapacity;
+        }
+
+        // Returns the fraction of slots that are occupied
+        float loadFactor() const
+        {
+            return (float)numberOfElements / slotCount();
+        }
+
+        // Returns the load factor past which the table grows
+        float getMaxLoadFactor() const
+        {
+            return maxLoadFactor;
+        }
+
+        // Grows the table so that it can hold at least the given number of
+        // elements without exceeding the maximum load factor
+        void reserve(size_t elementCount)
+        {
+            size_t requiredSlots = (size_t)(elementCount / maxLoadFactor) + 1;
+            size_t requiredCapacity = roundUpToPowerOfTwo((requiredSlots + SLOTS_PER_BUCKET - 1) / SLOTS_PER_BUCKET);
+            if (requiredCapacity > bucketArrayCapacity) rehash(requiredCapacity);
+        }
+
+    private:
+        static constexpr size_t SLOTS_PER_BUCKET = 4;
+
+        // The tag of an empty slot. Occupied slots have nonzero tags.
+        static constexpr uint8_t EMPTY_TAG = 0;
+
+        // The most buckets a breadth-first search for a free slot examines
+        // before giving up and growing the table. Reaches every path of up to
+        // four moves.
+        static constexpr size_t MAX_SEARCH_BUCKETS = 2 + 8 + 32 + 128 + 512;
+
+        struct alignas(64) Bucket
+        {
+            uint8_t tags[SLOTS_PER_BUCKET] = {};
+            alignas(CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>) unsigned char storage[SLOTS_PER_BUCKET][sizeof(CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>)];
+
+            CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>& slot(size_t index)
+            {
+                return *std::launder(reinterpret_cast<CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>*>(storage[index]));
+            }
+
+            // Returns the index of a free slot, or SLOTS_PER_BUCKET if the bucket is full
+            size_t freeSlot() const
+            {
+                for (size_t s = 0; s < SLOTS_PER_BUCKET; s++)
+                {
+                    if (tags[s] == EMPTY_TAG) return s;
+                }
+                return SLOTS_PER_BUCKET;
+            }
+        };
+
+        // A bucket reached by the breadth-first search, and how it was
+        // reached: by moving the entry in slot parentSlot of the parent bucket
+        struct SearchStep
+        {
+            size_t bucket;
+            size_t parent;
+            size_t parentSlot;
+        };
+
+        // The bucket array
+        Bucket* buckets;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The number of buckets (a power of two) and the mask that reduces a
+        // hash to a bucket index
+        size_t bucketArrayCapacity;
+        size_t mask;
+
+        // The number of elements in the table
+        size_t numberOfElements = 0;
+
+        // The load factor past which the table grows
+        float maxLoadFactor;
+
+        static size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t powerOfTwo = 2;
+            while (powerOfTwo < value) powerOfTwo *= 2;
+            return powerOfTwo;
+        }
+
+        size_t slotCount() const
+        {
+            return bucketArrayCapacity * SLOTS_PER_BUCKET;
+        }
+
+        void allocateBuckets(size_t newCapacity)
+        {
+            buckets = new Bucket[newCapacity];
+            bucketArrayCapacity = newCapacity;
+            mask = newCapacity - 1;
+        }
+
+        // The tag of a hash is its top byte, made nonzero
+        static uint8_t tagOf(size_t hash)
+        {
+            uint8_t tag = (uint8_t)(hash >> (sizeof(size_t) * 8 - 8));
+            return tag == EMPTY_TAG ? 1 : tag;
+        }
+
+        size_t firstBucket(size_t hash) const
+        {
+            return hash & mask;
+        }
+
+        // Returns the other bucket of an entry with the given tag in the given
+        // bucket. Applying it twice returns the original bucket.
+        size_t alternateBucket(size_t bucket, uint8_t tag) const
+        {
+            size_t offset = (size_t)(tag * 0xc6a4a7935bd1e995ULL) & mask;
+            return bucket ^ (offset == 0 ? 1 : offset);
+        }
+
+        // Finds the bucket and slot holding the key, returning false if there is none
+        bool findSlot(const KEY_TYPE& key, size_t hash, Bucket*& bucket, size_t& slot)
+        {
+            uint8_t tag = tagOf(hash);
+            size_t first = firstBucket(hash);
+            if (findInBucket(buckets[first], key, tag, slot))
+            {
+                bucket = &buckets[first];
+                return true;
+            }
+            size_t second = alternateBucket(first, tag);
+            if (findInBucket(buckets[second], key, tag, slot))
+            {
+                bucket = &buckets[second];
+                return true;
+            }
+            return false;
+        }
+
+        bool findInBucket(Bucket& bucket, const KEY_TYPE& key, uint8_t tag, size_t& slot)
+        {
+            for (slot = 0; slot < SLOTS_PER_BUCKET; slot++)
+            {
+                if (bucket.tags[slot] == tag && keyEqual(bucket.slot(slot).key, key)) return true;
+            }
+            return false;
+        }
+
+        VALUE_TYPE* findValue(const KEY_TYPE& key, size_t hash)
+        {
+            Bucket* bucket;
+            size_t slot;
+            if (findSlot(key, hash, bucket, slot)) return &bucket->slot(slot).value;
+            return nullptr;
+        }
+
+        // Moves an entry whose key is known not to be in the table into one of
+        // its buckets, moving other entries to their alternate buckets to make
+        // room if needed. Returns false, leaving the table unchanged, if no
+        // room can be found.
+        bool place(CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>& entry, size_t hash)
+        {
+            uint8_t tag = tagOf(hash);
+            size_t first = firstBucket(hash);
+
+            // Breadth-first search from both buckets for one with a free slot
+            SearchStep steps[MAX_SEARCH_BUCKETS];
+            steps[0] = SearchStep{first, 0, 0};
+            steps[1] = SearchStep{alternateBucket(first, tag), 0, 0};
+            size_t stepCount = 2;
+            for (size_t i = 0; i < stepCount; i++)
+            {
+                size_t freeSlot = buckets[steps[i].bucket].freeSlot();
+                if (freeSlot != SLOTS_PER_BUCKET)
+                {
+                    // Move each entry along the path into the slot freed
+                    // after it, starting from the end
+                    while (i > 1)
+                    {
+                        Bucket& from = buckets[steps[steps[i].parent].bucket];
+                        moveEntry(from, steps[i].parentSlot, buckets[steps[i].bucket], freeSlot);
+                        freeSlot = steps[i].parentSlot;
+                        i = steps[i].parent;
+                    }
+                    Bucket& destination = buckets[steps[i].bucket];
+                    new (destination.storage[freeSlot]) CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>(std::move(entry));
+                    destination.tags[freeSlot] = tag;
+                    return true;
+                }
+
+                // Every entry of a full bucket could move to its other bucket
+                for (size_t s = 0; s < SLOTS_PER_BUCKET && stepCount < MAX_SEARCH_BUCKETS; s++)
+                {
+                    steps[stepCount++] = SearchStep{alternateBucket(steps[i].bucket, buckets[steps[i].bucket].tags[s]), i, s};
+                }
+            }
+            return false;
+        }
+
+        void moveEntry(Bucket& from, size_t fromSlot, Bucket& to, size_t toSlot)
+        {
+            new (to.storage[toSlot]) CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>(std::move(from.slot(fromSlot)));
+            to.tags[toSlot] = from.tags[fromSlot];
+            from.slot(fromSlot).~CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            from.tags[fromSlot] = EMPTY_TAG;
+        }
+
+        // Moves every entry into a new bucket array of the given capacity. An
+        // entry that cannot be placed grows the new array again before the
+        // move carries on.
+        void rehash(size_t newCapacity)
+        {
+            Bucket* oldBuckets = buckets;
+            size_t oldCapacity = bucketArrayCapacity;
+            allocateBuckets(newCapacity);
+
+            for (size_t i = 0; i < oldCapacity; i++)
+            {
+                for (size_t s = 0; s < SLOTS_PER_BUCKET; s++)
+                {
+                    if (oldBuckets[i].tags[s] == EMPTY_TAG) continue;
+                    CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>& entry = oldBuckets[i].slot(s);
+                    size_t hash = hasher(entry.key);
+                    while (!place(entry, hash)) rehash(bucketArrayCapacity * 2);
+                    entry.~CuckooHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+                }
+            }
+
+            delete[] oldBuckets;
+        }
+};
+
+#endif
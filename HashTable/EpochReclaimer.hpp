@@ -0,0 +1,295 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file EpochReclaimer.hpp
+ * @brief Epoch-based memory reclamation for the lock-free collections. Memory
+ * unlinked from a shared structure is retired rather than freed, and is only
+ * freed once no thread can still be reading it.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef EPOCHRECLAIMER_H
+#define EPOCHRECLAIMER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A process-wide epoch counter, and a record for every thread that uses it.
+// A thread pins itself before reading a shared structure, which publishes the
+// epoch it saw in its own record, and unpins itself when it holds no more
+// pointers into the structure. The global epoch only advances once every
+// pinned thread has seen the current epoch, so memory retired in epoch E is
+// unreachable by every thread once the global epoch reaches E + 2.
+//
+// Pinning and unpinning only write the calling thread's own record, which
+// sits on its own cache line, so readers never contend with each other.
+class EpochReclaimer
+{
+    private:
+        struct ThreadRecord;
+
+    public:
+        // Keeps the calling thread pinned for the lifetime of the object.
+        // Guards may be nested.
+        class Guard
+        {
+            public:
+                explicit Guard(EpochReclaimer& reclaimer)
+                    : record(reclaimer.localRecord())
+                {
+                    reclaimer.pin(record);
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+                ~Guard()
+                {
+                    if (--record->pinDepth == 0) record->epoch.store(0, std::memory_order_release);
+                }
+
+            private:
+                ThreadRecord* record;
+        };
+
+        EpochReclaimer(const EpochReclaimer&) = delete;
+        EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+        // Returns the reclaimer shared by every collection in the process
+        static EpochReclaimer& instance()
+        {
+            static EpochReclaimer reclaimer;
+            return reclaimer;
+        }
+
+        // Pins the calling thread until the returned guard is destroyed
+        Guard pin()
+        {
+            return Guard(*this);
+        }
+
+        // Schedules an object to be destroyed by delete once no pinned thread
+        // can still hold a pointer to it. The object must already be
+        // unreachable from the shared structure.
+        template<typename T>
+        void retire(T* object)
+        {
+            retire(object, [](void* pointer) { delete static_cast<T*>(pointer); });
+        }
+
+        // Schedules deleter(object) to be called once no pinned thread can
+        // still hold a pointer to the object
+        void retire(void* object, void (*deleter)(void*))
+        {
+            ThreadRecord* record = localRecord();
+            record->retired.push_back(RetiredObject{object, deleter, globalEpoch.load(std::memory_order_seq_cst)});
+            if (record->retired.size() % COLLECT_INTERVAL == 0) collect(record);
+        }
+
+        // Tries to advance the global epoch, then frees every object retired
+        // by the calling thread that is no longer reachable
+        void collect()
+        {
+            collect(localRecord());
+        }
+
+        // Waits until every object retired by the calling thread before the
+        // call has been freed. The calling thread must not be pinned.
+        void synchronize()
+        {
+            ThreadRecord* record = localRecord();
+            while (!record->retired.empty() || hasOrphans.load(std::memory_order_acquire))
+            {
+                collect(record);
+                std::this_thread::yield();
+            }
+        }
+
+        // Returns the current global epoch
+        uint64_t epoch() const
+        {
+            return globalEpoch.load(std::memory_order_acquire);
+        }
+
+    private:
+        // The number of retirements between attempts to free retired objects
+        static constexpr size_t COLLECT_INTERVAL = 64;
+
+        struct RetiredObject
+        {
+            void* object;
+            void (*deleter)(void*);
+            uint64_t epoch;
+        };
+
+        // The state of one thread. Records are never freed; when a thread
+        // exits, its record is handed to the next new thread.
+        struct alignas(64) ThreadRecord
+        {
+            // The epoch the thread saw when it pinned itself, or 0 while unpinned
+            std::atomic<uint64_t> epoch{0};
+
+            // The number of guards the thread currently holds
+            size_t pinDepth = 0;
+
+            // Whether a live thread owns the record
+            std::atomic<bool> inUse{true};
+
+            // Objects the thread has retired, oldest first
+            std::vector<RetiredObject> retired;
+
+            ThreadRecord* next = nullptr;
+        };
+
+        // Releases the calling thread's record when the thread exits
+        struct LocalRecordHolder
+        {
+            EpochReclaimer* reclaimer = nullptr;
+            ThreadRecord* record = nullptr;
+
+            ~LocalRecordHolder()
+            {
+                if (record != nullptr) reclaimer->releaseRecord(record);
+            }
+        };
+
+        // The global epoch. It starts at 1 so that 0 can mean unpinned.
+        alignas(64) std::atomic<uint64_t> globalEpoch{1};
+
+        // Every record ever created, newest first
+        std::atomic<ThreadRecord*> records{nullptr};
+
+        // Objects left retired by threads that have exited
+        std::mutex orphansMutex;
+        std::vector<RetiredObject> orphans;
+        std::atomic<bool> hasOrphans{false};
+
+        EpochReclaimer() = default;
+
+        // Frees everything still retired. Only runs at process exit, once no
+        // other thread is using the reclaimer.
+        ~EpochReclaimer()
+        {
+            ThreadRecord* record = records.load(std::memory_order_acquire);
+            while (record != nullptr)
+            {
+                freeAll(record->retired);
+                ThreadRecord* next = record->next;
+                delete record;
+                record = next;
+            }
+            freeAll(orphans);
+        }
+
+        // Returns the calling thread's record, claiming one the first time
+        ThreadRecord* localRecord()
+        {
+            static thread_local LocalRecordHolder holder;
+            if (holder.record == nullptr)
+            {
+                holder.reclaimer = this;
+                holder.record = acquireRecord();
+            }
+            return holder.record;
+        }
+
+        // Reuses the record of an exited thread, or adds a new record
+        ThreadRecord* acquireRecord()
+        {
+            for (ThreadRecord* record = records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                bool expected = false;
+                if (!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) return record;
+            }
+
+            ThreadRecord* record = new ThreadRecord();
+            record->next = records.load(std::memory_order_relaxed);
+            while (!records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            return record;
+        }
+
+        // Hands whatever the exiting thread could not free to the orphan list
+        void releaseRecord(ThreadRecord* record)
+        {
+            collect(record);
+            if (!record->retired.empty())
+            {
+                std::lock_guard<std::mutex> lock(orphansMutex);
+                orphans.insert(orphans.end(), record->retired.begin(), record->retired.end());
+                hasOrphans.store(true, std::memory_order_release);
+            }
+            record->retired.clear();
+            record->retired.shrink_to_fit();
+            record->inUse.store(false, std::memory_order_release);
+        }
+
+        void pin(ThreadRecord* record)
+        {
+            if (record->pinDepth++ > 0) return;
+
+            // The release store carries the reads made under any earlier pin
+            // to the thread that sees it. The fence orders the published
+            // epoch before every read of the shared structure, and pairs with
+            // the fence in tryAdvance().
+            record->epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        // Advances the global epoch if every pinned thread has seen it, and
+        // returns the global epoch
+        uint64_t tryAdvance()
+        {
+            uint64_t current = globalEpoch.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (ThreadRecord* record = records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                uint64_t recordEpoch = record->epoch.load(std::memory_order_acquire);
+                if (recordEpoch != 0 && recordEpoch != current) return current;
+            }
+            if (globalEpoch.compare_exchange_strong(current, current + 1, std::memory_order_release, std::memory_order_relaxed)) return current + 1;
+            return current;
+        }
+
+        void collect(ThreadRecord* record)
+        {
+            uint64_t current = tryAdvance();
+            freeExpired(record->retired, current);
+
+            if (hasOrphans.load(std::memory_order_acquire))
+            {
+                std::unique_lock<std::mutex> lock(orphansMutex, std::try_to_lock);
+                if (lock.owns_lock())
+                {
+                    freeExpired(orphans, current);
+                    hasOrphans.store(!orphans.empty(), std::memory_order_release);
+                }
+            }
+        }
+
+        // Frees every object retired at least two epochs before the current one
+        static void freeExpired(std::vector<RetiredObject>& retired, uint64_t current)
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < retired.size(); i++)
+            {
+                if (retired[i].epoch + 2 <= current) retired[i].deleter(retired[i].object);
+                else retired[kept++] = retired[i];
+            }
+            retired.resize(kept);
+        }
+
+        static void freeAll(std::vector<RetiredObject>& retired)
+        {
+            for (size_t i = 0; i < retired.size(); i++) retired[i].deleter(retired[i].object);
+            retired.clear();
+        }
+};
+
+#endif
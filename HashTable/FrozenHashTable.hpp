@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file FrozenHashTable.hpp
+ * @brief Immutable key/value dictionary built from a HashTable. Uses a
+ * minimal perfect hash (hash and displace, in the style of CHD) so that every
+ * key has a slot of its own in one contiguous array.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef FROZENHASHTABLE_H
+#define FROZENHASHTABLE_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "./HashFunctions.hpp"
+#include "./HashTable.hpp"
+
+template<typename KEY_TYPE, typename VALUE_TYPE>
+struct FrozenHashTableEntry
+{
+    KEY_TYPE key;
+    VALUE_TYPE value;
+};
+
+// Keys are split into groups of about four by their hash, and every group is
+// given a displacement: either a seed that, mixed into the hash of each key in
+// the group, sends the keys to distinct free slots, or for a group of one key
+// the slot itself. Groups are placed largest first, while the most slots are
+// free. With n keys there are exactly n slots, so the table is minimal.
+//
+// A lookup hashes the key once, reads the displacement of its group, and
+// compares the key in the one slot that the key could be in. Entries hold no
+// pointers and no hashes; the only other memory is one 32-bit displacement
+// per group.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class FrozenHashTable
+{
+    public:
+        // Constructor. Copies every element of a hash table, along with its
+        // hash and key equality functors. Hashes stored in the hash table's
+        // nodes are reused rather than computed again.
+        // Algorithmic runtime: O(N) expected
+        explicit FrozenHashTable(const HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& source)
+            : hasher(source.hasher), keyEqual(source.keyEqual)
+        {
+            std::vector<const HashTableNode<KEY_TYPE, VALUE_TYPE>*> nodes;
+            std::vector<size_t> hashes;
+            nodes.reserve(source.numberOfElements);
+            hashes.reserve(source.numberOfElements);
+            source.forEachNode([&](const HashTableNode<KEY_TYPE, VALUE_TYPE>& node)
+            {
+                nodes.push_back(&node);
+                hashes.push_back(node.hash);
+            });
+            build(nodes, hashes);
+        }
+
+        FrozenHashTable(FrozenHashTable&& other) noexcept
+            : entries(other.entries), numberOfElements(other.numberOfElements), displacements(std::move(other.displacements)), hasher(std::move(other.hasher)), keyEqual(std::move(other.keyEqual))
+        {
+            other.entries = nullptr;
+            other.numberOfElements = 0;
+        }
+
+        FrozenHashTable(const FrozenHashTable&) = delete;
+        FrozenHashTable& operator=(const FrozenHashTable&) = delete;
+
+        // Destructor
+        ~FrozenHashTable()
+        {
+            destroyEntries(numberOfElements);
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1), with one key comparison
+        const VALUE_TYPE* get(const KEY_TYPE& key) const
+        {
+            if (numberOfElements == 0) return nullptr;
+            const FrozenHashTableEntry<KEY_TYPE, VALUE_TYPE>& entry = entries[slotOf(hasher(key))];
+            if (keyEqual(entry.key, key)) return &entry.value;
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1), with one key comparison
+        bool contains(const KEY_TYPE& key) const
+        {
+            return get(key) != nullptr;
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Prints the contents of the table to an output stream (the console by default)
+        void print(std::ostream& outputStream = std::cout) const
+        {
+            for (size_t i = 0; i < numberOfElements; i++) outputStream << entries[i].key << ": " << entries[i].value << std::endl;
+        }
+
+        // Returns the number of bytes used by the displacement array, the only
+        // memory used besides the entries themselves
+        size_t displacementBytes() const
+        {
+            return displacements.size() * sizeof(uint32_t);
+        }
+
+    private:
+        // A displacement with this bit set holds a slot index rather than a seed
+        static constexpr uint32_t DIRECT_SLOT = (uint32_t)1 << 31;
+
+        // The average number of keys per group
+        static constexpr size_t KEYS_PER_GROUP = 4;
+
+        // The number of seeds tried for a group before giving up
+        static constexpr uint32_t MAX_SEED_ATTEMPTS = (uint32_t)1 << 20;
+
+        // The entries, one per slot, and their number
+        FrozenHashTableEntry<KEY_TYPE, VALUE_TYPE>* entries = nullptr;
+        size_t numberOfElements = 0;
+
+        // The displacement of each group
+        std::vector<uint32_t> displacements;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        std::allocator<FrozenHashTableEntry<KEY_TYPE, VALUE_TYPE>> entryAllocator;
+
+        // Maps a hash to [0, range) using the high bits of a 128-bit product,
+        // which avoids a division
+        static size_t reduce(size_t hash, size_t range)
+        {
+#if defined(__SIZEOF_INT128__)
+            return (size_t)(((unsigned __int128)hash * range) >> 64);
+#else
+            return hash % range;
+#endif
+        }
+
+        // reduce() reads the high bits of the hash, which hashers such as
+        // std::hash<int> leave zero, so the hash is mixed first
+        size_t groupOf(size_t hash) const
+        {
+            return reduce(mixHashBits(hash), displacements.size());
+        }
+
+        size_t seededSlot(size_t hash, uint32_t seed) const
+        {
+            return reduce(mixHashBits(hash + seed * 0x9e3779b97f4a7c15ULL), numberOfElements);
+        }
+
+        size_t slotOf(size_t hash) const
+        {
+            uint32_t displacement = displacements[groupOf(hash)];
+            if (displacement & DIRECT_SLOT) return displacement & ~DIRECT_SLOT;
+            return seededSlot(hash, displacement);
+        }
+
+        // Finds a displacement for every group, then copies each node into its slot
+        void build(const std::vector<const HashTableNode<KEY_TYPE, VALUE_TYPE>*>& nodes, const std::vector<size_t>& hashes)
+        {
+            size_t keyCount = nodes.size();
+            if (keyCount == 0) return;
+            if (keyCount >= DIRECT_SLOT) throw std::length_error("Too many keys to freeze");
+            numberOfElements = keyCount;
+            displacements.assign((keyCount + KEYS_PER_GROUP - 1) / KEYS_PER_GROUP, 0);
+            size_t groupCount = displacements.size();
+
+            // Sort the keys by group with a counting sort
+            std::vector<size_t> groupStarts(groupCount + 1, 0);
+            for (size_t i = 0; i < keyCount; i++) groupStarts[groupOf(hashes[i]) + 1]++;
+            for (size_t g = 0; g < groupCount; g++) groupStarts[g + 1] += groupStarts[g];
+            std::vector<size_t> keysByGroup(keyCount);
+            std::vector<size_t> nextInGroup(groupStarts.begin(), groupStarts.end() - 1);
+            for (size_t i = 0; i < keyCount; i++) keysByGroup[nextInGroup[groupOf(hashes[i])]++] = i;
+
+            // Place the largest groups first
+            std::vector<size_t> groupOrder(groupCount);
+            for (size_t g = 0; g < groupCount; g++) groupOrder[g] = g;
+            std::stable_sort(groupOrder.begin(), groupOrder.end(), [&](size_t a, size_t b)
+            {
+                return groupStarts[a + 1] - groupStarts[a] > groupStarts[b + 1] - groupStarts[b];
+            });
+
+            std::vector<size_t> slotOfKey(keyCount);
+            std::vector<bool> slotTaken(keyCount, false);
+            size_t nextFreeSlot = 0;
+            for (size_t g : groupOrder)
+            {
+                size_t groupStart = groupStarts[g];
+                size_t groupSize = groupStarts[g + 1] - groupStart;
+                if (groupSize == 0) break;
+
+                // A group of one key takes the next free slot directly
+                if (groupSize == 1)
+                {
+                    while (slotTaken[nextFreeSlot]) nextFreeSlot++;
+                    slotTaken[nextFreeSlot] = true;
+                    slotOfKey[keysByGroup[groupStart]] = nextFreeSlot;
+                    displacements[g] = DIRECT_SLOT | (uint32_t)nextFreeSlot;
+                    continue;
+                }
+
+                uint32_t seed = 0;
+                while (!tryPlaceGroup(keysByGroup.data() + groupStart, groupSize, hashes, seed, slotTaken, slotOfKey))
+                {
+                    if (++seed == MAX_SEED_ATTEMPTS) throw std::overflow_error("Too many keys in the table share the same hash");
+                }
+                displacements[g] = seed;
+            }
+
+            // Copy every node into its slot, in slot order
+            std::vector<size_t> keyOfSlot(keyCount);
+            for (size_t i = 0; i < keyCount; i++) keyOfSlot[slotOfKey[i]] = i;
+            entries = entryAllocator.allocate(keyCount);
+            size_t constructed = 0;
+            try
+            {
+                for (; constructed < keyCount; constructed++)
+                {
+                    const HashTableNode<KEY_TYPE, VALUE_TYPE>* node = nodes[keyOfSlot[constructed]];
+                    new (&entries[constructed]) FrozenHashTableEntry<KEY_TYPE, VALUE_TYPE>{node->key, node->value};
+                }
+            }
+            catch (...)
+            {
+                destroyEntries(constructed);
+                numberOfElements = 0;
+                throw;
+            }
+        }
+
+        // Takes the slots that a seed sends a group's keys to, if they are all
+        // free and distinct
+        bool tryPlaceGroup(const size_t* keys, size_t groupSize, const std::vector<size_t>& hashes, uint32_t seed, std::vector<bool>& slotTaken, std::vector<size_t>& slotOfKey) const
+        {
+            for (size_t i = 0; i < groupSize; i++)
+            {
+                size_t slot = seededSlot(hashes[keys[i]], seed);
+                bool available = !slotTaken[slot];
+                for (size_t j = 0; j < i && available; j++) available = slotOfKey[keys[j]] != slot;
+                if (!available) return false;
+                slotOfKey[keys[i]] = slot;
+            }
+            for (size_t i = 0; i < groupSize; i++) slotTaken[slotOfKey[keys[i]]] = true;
+            return true;
+        }
+
+        void destroyEntries(size_t count)
+        {
+            if (entries == nullptr) return;
+            for (size_t i = 0; i < count; i++) entries[i].~FrozenHashTableEntry<KEY_TYPE, VALUE_TYPE>();
+            entryAllocator.deallocate(entries, numberOfElements);
+            entries = nullptr;
+        }
+};
+
+#endif
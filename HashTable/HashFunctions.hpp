@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file HashFunctions.hpp
+ * @brief Default hash functions for the hash table collections. Integral,
+ * string and plain-old-data keys are hashed in place without allocating;
+ * other types fall back to hashing their stream representation.
+ *
+ * To hash a user-defined key type, specialize DefaultHash for it:
+ *
+ *     template<>
+ *     struct DefaultHash<Point>
+ *     {
+ *         size_t operator()(const Point& point) const
+ *         {
+ *             return combineHashes(DefaultHash<int>()(point.x), DefaultHash<int>()(point.y));
+ *         }
+ *     };
+ *
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef HASHFUNCTIONS_H
+#define HASHFUNCTIONS_H
+#include <cstddef>
+#include <cstdint>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Mixes the bits of an integer so that every input bit affects every output
+// bit (the multiply-xorshift finalizer from splitmix64).
+constexpr size_t mixHashBits(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return (size_t)value;
+}
+
+// Hashes a run of bytes in place using 64-bit FNV-1a followed by a final mix.
+// See: https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+constexpr size_t hashBytes(const char* bytes, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return mixHashBits(hash);
+}
+
+// Combines two hashes into one, e.g. for hashing the members of a struct
+constexpr size_t combineHashes(size_t first, size_t second)
+{
+    return mixHashBits(first ^ (second + 0x9e3779b97f4a7c15ULL + (first << 6) + (first >> 2)));
+}
+
+// Hashes the stream representation of a key using the Jenkins one-at-a-time
+// hash. This allocates on every call and is only used for keys that have no
+// better option.
+// See: https://en.wikipedia.org/wiki/Jenkins_hash_function
+template<typename KEY_TYPE>
+size_t jenkinsStreamHash(const KEY_TYPE& key)
+{
+    // Convert the key to a string
+    std::stringstream hashStringStream;
+    hashStringStream << key;
+    std::string hashString = hashStringStream.str();
+
+    // Compute the hash using the Jenkins hash function
+    unsigned int hash = 0;
+    for (unsigned int i = 0; hashString[i] != '\0'; i++)
+    {
+        hash += hashString[i];
+        hash += hash << 10;
+        hash ^= hash >> 6;
+    }
+    hash += hash << 3;
+    hash ^= hash >> 11;
+    hash += hash << 15;
+    return hash;
+}
+
+// The hash used by the hash table collections when no other is provided.
+// Integral, enum and pointer keys are mixed directly, floating point keys and
+// keys whose bytes uniquely represent their value are hashed byte by byte,
+// and anything else falls back to jenkinsStreamHash.
+template<typename KEY_TYPE>
+struct DefaultHash
+{
+    constexpr size_t operator()(const KEY_TYPE& key) const
+    {
+        if constexpr (std::is_integral<KEY_TYPE>::value || std::is_enum<KEY_TYPE>::value)
+        {
+            return mixHashBits((uint64_t)key);
+        }
+        else if constexpr (std::is_pointer<KEY_TYPE>::value)
+        {
+            return mixHashBits((uint64_t)(uintptr_t)key);
+        }
+        else if constexpr (std::is_floating_point<KEY_TYPE>::value)
+        {
+            // Positive and negative zero compare equal, so they must hash equal
+            if (key == 0) return mixHashBits(0);
+            return hashBytes(reinterpret_cast<const char*>(&key), floatingPointValueBytes());
+        }
+        else if constexpr (std::has_unique_object_representations<KEY_TYPE>::value)
+        {
+            return hashObjectBytes(key);
+        }
+        else
+        {
+            return jenkinsStreamHash(key);
+        }
+    }
+
+    private:
+        static size_t hashObjectBytes(const KEY_TYPE& key)
+        {
+            return hashBytes(reinterpret_cast<const char*>(&key), sizeof(KEY_TYPE));
+        }
+
+        // The number of leading bytes of a floating point key that hold its
+        // value. The x87 80-bit extended format (a 64-bit significand) keeps
+        // its value in the low 10 bytes of a 12 or 16 byte long double, and
+        // the rest is padding that equal values need not share.
+        static constexpr size_t floatingPointValueBytes()
+        {
+            if (std::numeric_limits<KEY_TYPE>::digits == 64 && sizeof(KEY_TYPE) > 10) return 10;
+            return sizeof(KEY_TYPE);
+        }
+};
+
+// Strings are hashed over their characters in place. Every string type hashes
+// the same characters to the same value, so the string hashes are transparent:
+// a std::string_view or const char* can be hashed as a std::string key
+// without building one.
+template<>
+struct DefaultHash<std::string_view>
+{
+    using is_transparent = void;
+
+    constexpr size_t operator()(std::string_view key) const
+    {
+        return hashBytes(key.data(), key.size());
+    }
+};
+
+template<>
+struct DefaultHash<std::string> : DefaultHash<std::string_view> {};
+
+template<>
+struct DefaultHash<const char*>
+{
+    size_t operator()(const char* key) const
+    {
+        return hashBytes(key, std::strlen(key));
+    }
+};
+
+template<>
+struct DefaultHash<char*> : DefaultHash<const char*> {};
+
+// True if a hash or key equality functor accepts types other than the key
+// type, as marked by an is_transparent member type (the convention used by
+// std::equal_to<> and the standard unordered containers)
+template<typename FUNCTOR, typename = void>
+struct IsTransparent : std::false_type {};
+
+template<typename FUNCTOR>
+struct IsTransparent<FUNCTOR, std::void_t<typename FUNCTOR::is_transparent>> : std::true_type {};
+
+// Adapts a hash function pointer of the form used by earlier versions of
+// HashTable, which reduces the hash by a modulus itself, to a std::hash
+// compatible functor. The function is given the largest modulus so that the
+// table can reduce the result to its own bucket count. Pass it as HASH to
+// construct a HashTable from a function pointer:
+//
+//     HashTable<int, int, FunctionPointerHash<int>> table(100, &myHash);
+//
+// Without a function it hashes with DefaultHash, so the call never needs a check.
+template<typename KEY_TYPE>
+struct FunctionPointerHash
+{
+    unsigned int (*hashFunction)(KEY_TYPE key, unsigned int modulus) = &defaultHashFunction;
+
+    FunctionPointerHash() = default;
+
+    explicit FunctionPointerHash(unsigned int (*hashFunction)(KEY_TYPE, unsigned int))
+        : hashFunction(hashFunction != nullptr ? hashFunction : &defaultHashFunction)
+    {
+    }
+
+    size_t operator()(const KEY_TYPE& key) const
+    {
+        return hashFunction(key, UINT_MAX);
+    }
+
+    static unsigned int defaultHashFunction(KEY_TYPE key, unsigned int modulus)
+    {
+        return (unsigned int)(DefaultHash<KEY_TYPE>()(key) % modulus);
+    }
+};
+
+#endif
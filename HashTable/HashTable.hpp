@@ -10,6 +10,26 @@
 
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "./HashFunctions.hpp"
+#include "./SlabAllocator.hpp"
+#include "./SnapshotFile.hpp"
 
 template<typename KEY_TYPE, typename VALUE_TYPE>
 struct HashTableNode
@@ -17,24 +37,121 @@ struct HashTableNode
     KEY_TYPE key;
     VALUE_TYPE value;
     HashTableNode<KEY_TYPE, VALUE_TYPE>* next = nullptr;
+
+    // The full hash of the key. Chain walks compare it before comparing keys,
+    // and rehashing uses it instead of hashing the key again.
+    size_t hash = 0;
 };
 
+// What a hash table iterator refers to: the key and value of one element.
+// Held by value, so `for (auto [key, value] : table)` binds straight to the
+// element, and it provides operator-> so that `iterator->value` works too.
 template<typename KEY_TYPE, typename VALUE_TYPE>
+struct HashTableEntryReference
+{
+    const KEY_TYPE& key;
+    VALUE_TYPE& value;
+
+    const HashTableEntryReference* operator->() const
+    {
+        return this;
+    }
+};
+
+// Raw storage for the nodes of a table in small mode, held inside the table
+// object itself. A table with no inline capacity holds no storage.
+template<typename NODE_TYPE, size_t CAPACITY>
+struct HashTableInlineNodes
+{
+    alignas(NODE_TYPE) unsigned char storage[CAPACITY * sizeof(NODE_TYPE)];
+
+    NODE_TYPE* nodes()
+    {
+        return reinterpret_cast<NODE_TYPE*>(storage);
+    }
+
+    const NODE_TYPE* nodes() const
+    {
+        return reinterpret_cast<const NODE_TYPE*>(storage);
+    }
+};
+
+template<typename NODE_TYPE>
+struct HashTableInlineNodes<NODE_TYPE, 0>
+{
+    NODE_TYPE* nodes()
+    {
+        return nullptr;
+    }
+
+    const NODE_TYPE* nodes() const
+    {
+        return nullptr;
+    }
+};
+
+// Enables the heterogeneous lookup overloads of a table, which take any type
+// of key that both the hash and key equality functors accept, when both are
+// transparent
+template<typename LOOKUP_KEY, typename KEY_TYPE, typename HASH, typename KEY_EQUAL>
+using EnableIfHeterogeneousLookup = std::enable_if_t<IsTransparent<HASH>::value && IsTransparent<KEY_EQUAL>::value && !std::is_same<std::decay_t<LOOKUP_KEY>, KEY_TYPE>::value>;
+
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH, typename KEY_EQUAL>
+class ShardedHashTable;
+
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH, typename KEY_EQUAL>
+class FrozenHashTable;
+
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH, typename KEY_EQUAL>
+class MappedHashTableBuilder;
+
+// HASH and KEY_EQUAL are std::hash and std::equal_to compatible functors.
+// Because they are template parameters rather than function pointers, the
+// compiler can inline them into every lookup. If both are transparent (have
+// an is_transparent member type, as DefaultHash<std::string> and
+// std::equal_to<> do) then get, contains, remove and getHash also accept keys
+// of other types, such as a std::string_view or const char* for a
+// std::string key, and hash and compare them without building a KEY_TYPE.
+//
+// A table with an INLINE_CAPACITY above zero starts in small mode: its first
+// INLINE_CAPACITY elements are kept in nodes inside the table object and
+// found by comparing keys one after another, with no hashing. Only when one
+// more element is inserted (or more are reserved) does it allocate its table
+// array and move the elements into hashed buckets, which invalidates
+// pointers to their values. Constructing a small table allocates nothing.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>, size_t INLINE_CAPACITY = 0>
 class HashTable
 {
     public:
-        // Constructor
-        HashTable(size_t tableSize = 100, unsigned int (*hashFunction)(KEY_TYPE, unsigned int) = nullptr)
+        // The type of the hash function pointer taken by the first
+        // constructor: a function when HASH is FunctionPointerHash, and
+        // otherwise only nullptr
+        using HashFunctionArgument = std::conditional_t<std::is_same<HASH, FunctionPointerHash<KEY_TYPE>>::value, unsigned int (*)(KEY_TYPE, unsigned int), std::nullptr_t>;
+
+        // Constructor. The table array grows automatically once the load
+        // factor (elements per bucket) would exceed maxLoadFactor; pass
+        // infinity to keep the table array at a fixed size. A hash function
+        // pointer may only be given when HASH is FunctionPointerHash, which
+        // keeps the hash a plain functor call; other tables take nullptr.
+        HashTable(size_t tableSize = 100, HashFunctionArgument hashFunction = nullptr, float maxLoadFactor = 1.0f)
+            : HashTable(tableSize, makeHasher(hashFunction), KEY_EQUAL(), maxLoadFactor)
+        {
+        }
+
+        // Constructor taking hash and key equality functor instances
+        HashTable(size_t tableSize, const HASH& hasher, const KEY_EQUAL& keyEqual = KEY_EQUAL(), float maxLoadFactor = 1.0f)
+            : hasher(hasher), keyEqual(keyEqual)
         {
-            // Initialize the table and internal variables
-            this->table = new HashTableNode<KEY_TYPE, VALUE_TYPE>*[tableSize];
-            for (size_t i = 0; i < tableSize; i++) table[i] = nullptr;
+            // A table array must have at least one bucket
+            if (tableSize == 0) tableSize = 1;
+            if (!(maxLoadFactor > 0)) throw std::invalid_argument("The maximum load factor must be greater than zero");
+
+            // Initialize the table and internal variables. A table in small
+            // mode allocates its table array when it leaves small mode.
+            this->table = INLINE_CAPACITY > 0 ? nullptr : allocateTableArray(tableSize);
             this->numberOfElements = 0;
             this->tableArrayCapacity = tableSize;
-
-            // Set the hash function
-            if (hashFunction == nullptr) this->hashFunction = &this->jenkinsHashFunction;
-            else this->hashFunction = hashFunction;
+            this->maxLoadFactor = maxLoadFactor;
         }
 
         // Destructor
@@ -44,133 +161,337 @@ class HashTable
             this->clear();
 
             // Delete the table
-            delete[] this->table;
+            freeTableArray(this->table);
         }
 
         // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
-        void insert(KEY_TYPE key, VALUE_TYPE value)
+        // Hashes the key once and walks its chain once. The key and value are
+        // copied into the node once each.
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
         {
-            // Get the hash of the key
-            unsigned int hash = hashFunction(key, this->tableArrayCapacity);
+            insertKeyValue(key, value);
+        }
 
-            // Check if the key already exists, overwrite the value if it does and return
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[hash];
-            while (current != nullptr)
-            {
-                if (current->key == key)
-                {
-                    current->value = value;
-                    return;
-                }
-                current = current->next;
-            }
+        // Inserts a key/value pair like insert(), moving rather than copying
+        // whichever of the key and value are rvalues
+        void insert(KEY_TYPE&& key, VALUE_TYPE&& value)
+        {
+            insertKeyValue(std::move(key), std::move(value));
+        }
 
-            // The key does not exist, so a new node must be created
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* newNode = new HashTableNode<KEY_TYPE, VALUE_TYPE>;
-            newNode->key = key;
-            newNode->value = value;
-            newNode->next = nullptr;
+        void insert(const KEY_TYPE& key, VALUE_TYPE&& value)
+        {
+            insertKeyValue(key, std::move(value));
+        }
 
-            // Insert the new node into the hash table
-            if (table[hash] == nullptr) table[hash] = newNode;
-            else
-            {
-                current = table[hash];
-                while (current->next != nullptr) current = current->next;
-                current->next = newNode;
-            }
+        void insert(KEY_TYPE&& key, const VALUE_TYPE& value)
+        {
+            insertKeyValue(std::move(key), value);
+        }
 
-            // Increment the number of elements in the table
-            numberOfElements++;
+        // Inserts a key/value pair, constructing the value in place from the
+        // arguments. If the key already exists, the value is overwritten by a
+        // value constructed from the arguments. Returns a reference to the
+        // value, and true if the key was inserted or false if it was overwritten.
+        template<typename... VALUE_ARGUMENTS>
+        std::pair<VALUE_TYPE&, bool> emplace(const KEY_TYPE& key, VALUE_ARGUMENTS&&... valueArguments)
+        {
+            return emplaceKey(key, std::forward<VALUE_ARGUMENTS>(valueArguments)...);
         }
 
-        // Removes a key/value pair from the table if it exists, returns false if it does not exist
-        bool remove(KEY_TYPE key)
+        template<typename... VALUE_ARGUMENTS>
+        std::pair<VALUE_TYPE&, bool> emplace(KEY_TYPE&& key, VALUE_ARGUMENTS&&... valueArguments)
         {
-            // Get the hash of the key
-            unsigned int hash = hashFunction(key, this->tableArrayCapacity);
+            return emplaceKey(std::move(key), std::forward<VALUE_ARGUMENTS>(valueArguments)...);
+        }
 
-            // Search for the key
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[hash];
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* previous = nullptr;
-            while (current != nullptr)
-            {
-                // Check if we have found the key
-                if (current->key == key)
-                {
-                    // The key exists, so remove its node
-                    if (previous == nullptr) table[hash] = current->next;
-                    else previous->next = current->next;
-                    delete current;
-                    numberOfElements--;
-                    return true;
-                }
-                previous = current;
-                current = current->next;
-            }
+        // Returns a reference to the value associated with the key and false
+        // if the key exists. Otherwise constructs the value in place from the
+        // arguments, inserts it, and returns a reference to it and true.
+        template<typename... VALUE_ARGUMENTS>
+        std::pair<VALUE_TYPE&, bool> tryEmplace(const KEY_TYPE& key, VALUE_ARGUMENTS&&... valueArguments)
+        {
+            return findOrInsertKey(key, [&]() { return VALUE_TYPE(std::forward<VALUE_ARGUMENTS>(valueArguments)...); });
+        }
 
-            // The key does not exist
-            return false;
+        template<typename... VALUE_ARGUMENTS>
+        std::pair<VALUE_TYPE&, bool> tryEmplace(KEY_TYPE&& key, VALUE_ARGUMENTS&&... valueArguments)
+        {
+            return findOrInsertKey(std::move(key), [&]() { return VALUE_TYPE(std::forward<VALUE_ARGUMENTS>(valueArguments)...); });
         }
 
-        // Returns a pointer to the value associated with the key, or null if the key does not exist
-        VALUE_TYPE* get(KEY_TYPE key)
+        // Returns a reference to the value associated with the key and false
+        // if the key exists. Otherwise inserts the value returned by calling
+        // valueFactory(), and returns a reference to it and true. The factory
+        // is only called when the key is inserted. Either way the key is
+        // hashed once and its chain is walked once.
+        template<typename VALUE_FACTORY>
+        std::pair<VALUE_TYPE&, bool> findOrInsert(const KEY_TYPE& key, VALUE_FACTORY&& valueFactory)
         {
-            // Get the hash of the key
-            unsigned int hash = hashFunction(key, this->tableArrayCapacity);
+            return findOrInsertKey(key, valueFactory);
+        }
 
-            // Search for the key
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[hash];
-            while (current != nullptr)
-            {
-                // Check if we have found the key, return a pointer to the value if we have
-                if (current->key == key) return &current->value;
+        // Like findOrInsert() above, moving the key into the node if it is inserted
+        template<typename VALUE_FACTORY>
+        std::pair<VALUE_TYPE&, bool> findOrInsert(KEY_TYPE&& key, VALUE_FACTORY&& valueFactory)
+        {
+            return findOrInsertKey(std::move(key), valueFactory);
+        }
 
-                // Move to the next node if we have not found the key
-                current = current->next;
-            }
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        bool remove(const KEY_TYPE& key)
+        {
+            return removeKey(key);
+        }
+
+        // Removes a key/value pair by a key of another type, with transparent functors
+        template<typename LOOKUP_KEY, typename = EnableIfHeterogeneousLookup<LOOKUP_KEY, KEY_TYPE, HASH, KEY_EQUAL>>
+        bool remove(const LOOKUP_KEY& key)
+        {
+            return removeKey(key);
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        VALUE_TYPE* get(const KEY_TYPE& key)
+        {
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
+
+            // Search for the key, return a pointer to the value if we find it
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findNodeOfKey(key);
+            if (node != nullptr) return &node->value;
 
             // The key does not exist
             return nullptr;
         }
 
+        // Returns a pointer to the value associated with a key of another type, with transparent functors
+        template<typename LOOKUP_KEY, typename = EnableIfHeterogeneousLookup<LOOKUP_KEY, KEY_TYPE, HASH, KEY_EQUAL>>
+        VALUE_TYPE* get(const LOOKUP_KEY& key)
+        {
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
+
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findNodeOfKey(key);
+            return node != nullptr ? &node->value : nullptr;
+        }
+
         // Returns true if the key exists in the table, false if it does not
-        bool contains(KEY_TYPE key)
+        bool contains(const KEY_TYPE& key)
         {
-            // Get the hash of the key
-            unsigned int hash = hashFunction(key, this->tableArrayCapacity);
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
 
-            // Search for the key
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[hash];
-            while (current != nullptr)
+            return findNodeOfKey(key) != nullptr;
+        }
+
+        // Returns true if a key of another type exists in the table, with transparent functors
+        template<typename LOOKUP_KEY, typename = EnableIfHeterogeneousLookup<LOOKUP_KEY, KEY_TYPE, HASH, KEY_EQUAL>>
+        bool contains(const LOOKUP_KEY& key)
+        {
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
+
+            return findNodeOfKey(key) != nullptr;
+        }
+
+        // Looks up a batch of keys, storing a pointer to the value of each key
+        // (or null if the key does not exist) in the matching element of values.
+        // Every key is hashed and its bucket prefetched before any chain is
+        // walked, so the cache misses of the whole batch overlap instead of
+        // being taken one after another.
+        void getBatch(const KEY_TYPE* keys, size_t count, VALUE_TYPE** values)
+        {
+            lookupBatch(keys, count, [&](size_t i, HashTableNode<KEY_TYPE, VALUE_TYPE>* node)
             {
-                // Check if we have found the key, return true if we have
-                if (current->key == key) return true;
+                values[i] = node != nullptr ? &node->value : nullptr;
+            });
+        }
 
-                // Move to the next node if we have not found the key
-                current = current->next;
+        // Looks up a batch of keys like getBatch(), storing whether each key
+        // exists in the matching element of results
+        void containsBatch(const KEY_TYPE* keys, size_t count, bool* results)
+        {
+            lookupBatch(keys, count, [&](size_t i, HashTableNode<KEY_TYPE, VALUE_TYPE>* node)
+            {
+                results[i] = node != nullptr;
+            });
+        }
+
+        // Inserts every key/value pair in [begin, end) on threadCount threads
+        // (all hardware threads if 0). When a key appears more than once, or
+        // is already in the table, the last value wins.
+        template<typename RANDOM_ACCESS_ITERATOR>
+        void bulkBuild(RANDOM_ACCESS_ITERATOR begin, RANDOM_ACCESS_ITERATOR end, size_t threadCount = 0)
+        {
+            bulkBuild(begin, end, threadCount, [](VALUE_TYPE& combined, const VALUE_TYPE& next) { combined = next; });
+        }
+
+        // Inserts every key/value pair in [begin, end) on threadCount threads
+        // (all hardware threads if 0). When a key appears more than once, or
+        // is already in the table, combine(combined, next) is called to fold
+        // each later value into the earlier one, in input order. Pairs are
+        // copied, or moved through a std::move_iterator. If constructing an
+        // element throws, the elements inserted so far remain.
+        //
+        // The table array is sized once for every pair. Then, in parallel,
+        // the keys are hashed and the pairs partitioned by destination bucket
+        // range, keeping input order within each partition; and each thread
+        // links the nodes of one partition into its own range of buckets,
+        // allocating them from a slab allocator of its own. No two threads
+        // touch the same bucket, so neither pass takes a lock.
+        // Algorithmic runtime: O(N / threads + buckets) expected
+        template<typename RANDOM_ACCESS_ITERATOR, typename COMBINE_FUNCTION>
+        void bulkBuild(RANDOM_ACCESS_ITERATOR begin, RANDOM_ACCESS_ITERATOR end, size_t threadCount, COMBINE_FUNCTION combine)
+        {
+            static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<RANDOM_ACCESS_ITERATOR>::iterator_category>::value, "bulkBuild() needs random access iterators");
+            size_t count = (size_t)(end - begin);
+            if (count == 0) return;
+
+            // Pairs that fit inline are inserted one at a time
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr && numberOfElements + count <= INLINE_CAPACITY)
+                {
+                    for (RANDOM_ACCESS_ITERATOR current = begin; current != end; ++current)
+                    {
+                        auto&& element = *current;
+                        VALUE_TYPE* existing = get(element.first);
+                        if (existing != nullptr) combine(*existing, std::forward<decltype(element)>(element).second);
+                        else insert(std::forward<decltype(element)>(element).first, std::forward<decltype(element)>(element).second);
+                    }
+                    return;
+                }
             }
 
-            // The key does not exist
-            return false;
+            // Size the table for the worst case so that it never grows while
+            // nodes are being linked into it
+            reserve(numberOfElements + count);
+            completeRehash();
+            size_t capacity = tableArrayCapacity;
+
+            // Small batches are not worth a thread each
+            if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+            if (threadCount > count / BULK_BUILD_MIN_ELEMENTS_PER_THREAD) threadCount = count / BULK_BUILD_MIN_ELEMENTS_PER_THREAD;
+            if (threadCount > capacity) threadCount = capacity;
+            if (threadCount == 0) threadCount = 1;
+            size_t bucketsPerPartition = (capacity + threadCount - 1) / threadCount;
+            size_t elementsPerThread = (count + threadCount - 1) / threadCount;
+
+            // Pass 1: hash each thread's share of the input and count how
+            // many of its pairs fall in each partition.
+            // partitionCounts[thread * threadCount + partition]
+            std::vector<size_t> hashes(count);
+            std::vector<size_t> partitionCounts(threadCount * threadCount, 0);
+            std::exception_ptr error = runOnThreads(threadCount, [&](size_t thread)
+            {
+                size_t last = elementsPerThread * (thread + 1) < count ? elementsPerThread * (thread + 1) : count;
+                for (size_t i = elementsPerThread * thread; i < last; i++)
+                {
+                    hashes[i] = hashKey(begin[i].first);
+                    partitionCounts[thread * threadCount + (hashes[i] % capacity) / bucketsPerPartition]++;
+                }
+            });
+            if (error) std::rethrow_exception(error);
+
+            // Each partition lists the pairs of thread 0's share first, then
+            // thread 1's, and so on, so that input order is kept
+            std::vector<size_t> partitionStarts(threadCount + 1, 0);
+            std::vector<size_t> writePositions(threadCount * threadCount);
+            size_t position = 0;
+            for (size_t partition = 0; partition < threadCount; partition++)
+            {
+                partitionStarts[partition] = position;
+                for (size_t thread = 0; thread < threadCount; thread++)
+                {
+                    writePositions[thread * threadCount + partition] = position;
+                    position += partitionCounts[thread * threadCount + partition];
+                }
+            }
+            partitionStarts[threadCount] = position;
+
+            // Scatter the index of each pair into its partition
+            std::vector<size_t> order(count);
+            error = runOnThreads(threadCount, [&](size_t thread)
+            {
+                size_t last = elementsPerThread * (thread + 1) < count ? elementsPerThread * (thread + 1) : count;
+                for (size_t i = elementsPerThread * thread; i < last; i++)
+                {
+                    order[writePositions[thread * threadCount + (hashes[i] % capacity) / bucketsPerPartition]++] = i;
+                }
+            });
+            if (error) std::rethrow_exception(error);
+
+            // Pass 2: link each partition's pairs into its own range of buckets
+            std::vector<std::unique_ptr<SlabAllocator<HashTableNode<KEY_TYPE, VALUE_TYPE>>>> allocators(threadCount);
+            std::vector<size_t> insertedCounts(threadCount, 0);
+            for (size_t t = 0; t < threadCount; t++) allocators[t].reset(new SlabAllocator<HashTableNode<KEY_TYPE, VALUE_TYPE>>());
+            error = runOnThreads(threadCount, [&](size_t thread)
+            {
+                for (size_t p = partitionStarts[thread]; p < partitionStarts[thread + 1]; p++)
+                {
+                    size_t i = order[p];
+                    size_t hash = hashes[i];
+                    auto&& element = begin[i];
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucket = table[hash % capacity];
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* existing = bucket;
+                    while (existing != nullptr && !(existing->hash == hash && keyEqual(existing->key, element.first))) existing = existing->next;
+                    if (existing != nullptr)
+                    {
+                        combine(existing->value, std::forward<decltype(element)>(element).second);
+                        continue;
+                    }
+
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* node = allocators[thread]->allocate();
+                    try
+                    {
+                        new (node) HashTableNode<KEY_TYPE, VALUE_TYPE>{std::forward<decltype(element)>(element).first, std::forward<decltype(element)>(element).second, bucket, hash};
+                    }
+                    catch (...)
+                    {
+                        allocators[thread]->deallocate(node);
+                        throw;
+                    }
+                    bucket = node;
+                    insertedCounts[thread]++;
+                }
+            });
+
+            // Take ownership of the new nodes, even if a construction failed
+            for (size_t t = 0; t < threadCount; t++)
+            {
+                nodeAllocator.absorb(*allocators[t]);
+                numberOfElements += insertedCounts[t];
+            }
+            if (error) std::rethrow_exception(error);
         }
 
         // Clears all elements from the table, freeing the associated memory. Does not delete the table itself.
+        // Nodes are destroyed in place and their slabs are freed all at once;
+        // nodes that need no destructor are not visited at all.
         void clear()
         {
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* current;
-            HashTableNode<KEY_TYPE, VALUE_TYPE>* next;
-            for (size_t i = 0; i < this->tableArrayCapacity; i++)
+            if constexpr (INLINE_CAPACITY > 0)
             {
-                current = table[i];
-                while (current != nullptr)
+                if (table == nullptr)
                 {
-                    next = current->next;
-                    delete current;
-                    current = next;
+                    for (size_t i = 0; i < numberOfElements; i++) inlineNodes.nodes()[i].~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+                    numberOfElements = 0;
+                    return;
                 }
             }
-            for (size_t i = 0; i < this->tableArrayCapacity; i++) table[i] = nullptr;
+
+            destroyChains(table, tableArrayCapacity);
+            std::memset(table, 0, tableArrayCapacity * sizeof(HashTableNode<KEY_TYPE, VALUE_TYPE>*));
+
+            // Abandon any incremental rehash along with the old table array
+            if (oldTable != nullptr)
+            {
+                destroyChains(oldTable, oldTableCapacity);
+                freeTableArray(oldTable);
+                oldTable = nullptr;
+            }
+            nodeAllocator.release();
             numberOfElements = 0;
         }
 
@@ -189,63 +510,1035 @@ class HashTable
         // Prints the contents of the table to an output stream (the console by default)
         void print(std::stringstream& outputStream = std::cout)
         {
-            for (size_t i = 0; i < this->tableArrayCapacity; i++)
+            if constexpr (INLINE_CAPACITY > 0)
             {
-                HashTableNode<KEY_TYPE, VALUE_TYPE>* current = table[i];
-                while (current != nullptr)
+                if (table == nullptr)
                 {
-                    outputStream << current->key << ": " << current->value << std::endl;
-                    current = current->next;
+                    for (size_t i = 0; i < numberOfElements; i++) outputStream << inlineNodes.nodes()[i].key << ": " << inlineNodes.nodes()[i].value << std::endl;
+                    return;
+                }
+            }
+            if (oldTable != nullptr) printChains(oldTable, oldTableCapacity, outputStream);
+            printChains(table, tableArrayCapacity, outputStream);
+        }
+
+        // Writes every element to a binary snapshot file at the given path.
+        // The snapshot is written to the path with ".tmp" appended and only
+        // then replaces any file at the path, so a failed save leaves the
+        // previous snapshot intact. Each element is written with its hash, so
+        // that loadSnapshot() can place it without hashing the key again.
+        // Keys and values are encoded by SnapshotCodec: trivially copyable
+        // types as their bytes, and std::string with its length. Pointers,
+        // whose addresses would not survive a restart, are not accepted. Throws
+        // std::runtime_error if the file cannot be written.
+        // Algorithmic runtime: O(N + buckets)
+        void saveSnapshot(const std::string& path) const
+        {
+            SnapshotWriter writer(path);
+            SnapshotHeader::describe<KEY_TYPE, VALUE_TYPE>(numberOfElements, tableArrayCapacity).write(writer);
+            forEachNode([&](const HashTableNode<KEY_TYPE, VALUE_TYPE>& node)
+            {
+                // Inline nodes do not store their hash
+                writer.writeValue((uint64_t)(table == nullptr ? hashKey(node.key) : node.hash));
+                SnapshotCodec<KEY_TYPE>::write(writer, node.key);
+                SnapshotCodec<VALUE_TYPE>::write(writer, node.value);
+            });
+            writer.close();
+        }
+
+        // Replaces the contents of the table with those of a snapshot file
+        // written by saveSnapshot(). The table array is sized once for every
+        // element, with the saved bucket count if it is within a few times
+        // what the elements need, and each node is linked straight into the
+        // bucket given by its stored hash, without probing or comparing keys.
+        // If the first key no longer hashes to its stored hash (the snapshot
+        // was written with another hash function), every key is hashed again
+        // instead. Throws std::runtime_error if the file cannot be read, is
+        // not a snapshot of this version, was written for other key or value
+        // types, or is too short for its element count. A rejected header
+        // leaves the table unchanged, and a failure part way through leaves
+        // it empty.
+        // Algorithmic runtime: O(N + buckets)
+        void loadSnapshot(const std::string& path)
+        {
+            SnapshotReader reader(path);
+            SnapshotHeader header = SnapshotHeader::read<KEY_TYPE, VALUE_TYPE>(reader);
+            clear();
+            try
+            {
+                if constexpr (INLINE_CAPACITY > 0)
+                {
+                    if (table == nullptr && header.elementCount <= INLINE_CAPACITY)
+                    {
+                        for (uint64_t i = 0; i < header.elementCount; i++)
+                        {
+                            reader.readValue<uint64_t>();
+                            KEY_TYPE key = SnapshotCodec<KEY_TYPE>::read(reader);
+                            insert(std::move(key), SnapshotCodec<VALUE_TYPE>::read(reader));
+                        }
+                        return;
+                    }
+                }
+
+                // The saved bucket count comes from the file, so it is only
+                // trusted up to a small multiple of what the elements need.
+                // With growth disabled (an infinite maximum load factor) they
+                // need no buckets at all, so the limit follows the element
+                // count instead, and the saved count is what keeps the chains
+                // as short as they were.
+                size_t requiredCapacity = (size_t)std::ceil(header.elementCount / maxLoadFactor);
+                size_t limitBase = requiredCapacity > header.elementCount ? requiredCapacity : (size_t)header.elementCount;
+                size_t capacityLimit = (limitBase > 0 ? limitBase : 1) * SNAPSHOT_MAX_CAPACITY_FACTOR;
+                size_t savedCapacity = header.bucketCount < capacityLimit ? (size_t)header.bucketCount : capacityLimit;
+                rehash(savedCapacity > requiredCapacity ? savedCapacity : requiredCapacity);
+
+                bool hashKeys = false;
+                for (uint64_t i = 0; i < header.elementCount; i++)
+                {
+                    size_t hash = (size_t)reader.readValue<uint64_t>();
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* node = nodeAllocator.allocate();
+                    try
+                    {
+                        // Braced initialization reads the key before the value
+                        new (node) HashTableNode<KEY_TYPE, VALUE_TYPE>{SnapshotCodec<KEY_TYPE>::read(reader), SnapshotCodec<VALUE_TYPE>::read(reader), nullptr, hash};
+                    }
+                    catch (...)
+                    {
+                        nodeAllocator.deallocate(node);
+                        throw;
+                    }
+                    if (i == 0) hashKeys = hashKey(node->key) != hash;
+                    if (hashKeys) node->hash = hashKey(node->key);
+
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucket = table[node->hash % tableArrayCapacity];
+                    node->next = bucket;
+                    bucket = node;
+                    numberOfElements++;
                 }
             }
+            catch (...)
+            {
+                clear();
+                throw;
+            }
         }
 
         // Returns the hash for the given key
-        unsigned int getHash(KEY_TYPE key)
+        unsigned int getHash(const KEY_TYPE& key)
         {
-            return hashFunction(key, this->tableArrayCapacity);
+            return (unsigned int)bucketIndex(key);
+        }
+
+        // Returns the hash for a key of another type, with transparent functors
+        template<typename LOOKUP_KEY, typename = EnableIfHeterogeneousLookup<LOOKUP_KEY, KEY_TYPE, HASH, KEY_EQUAL>>
+        unsigned int getHash(const LOOKUP_KEY& key)
+        {
+            return (unsigned int)bucketIndex(key);
+        }
+
+        // Returns the number of buckets in the table array. In small mode this
+        // is the number of buckets the table array will have when allocated.
+        size_t bucketCount() const
+        {
+            return tableArrayCapacity;
         }
-    
-    private:
-        // The hash table array
-        HashTableNode<KEY_TYPE, VALUE_TYPE>** table;
 
-        unsigned int (*hashFunction)(KEY_TYPE key, unsigned int modulus);
+        // Returns the average number of elements per bucket
+        float loadFactor() const
+        {
+            return (float)numberOfElements / tableArrayCapacity;
+        }
+
+        // Returns the load factor past which the table array grows
+        float getMaxLoadFactor() const
+        {
+            return maxLoadFactor;
+        }
+
+        // Sets the load factor past which the table array grows, rehashing
+        // immediately if the current load factor already exceeds it
+        void setMaxLoadFactor(float maxLoadFactor)
+        {
+            if (!(maxLoadFactor > 0)) throw std::invalid_argument("The maximum load factor must be greater than zero");
+            this->maxLoadFactor = maxLoadFactor;
+            if (loadFactor() > maxLoadFactor) rehash(0);
+        }
+
+        // Sizes the table array so that it can hold at least the given number
+        // of elements without exceeding the maximum load factor. Reserving
+        // more elements than fit inline leaves small mode.
+        void reserve(size_t elementCount)
+        {
+            size_t requiredCapacity = (size_t)std::ceil(elementCount / maxLoadFactor);
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr)
+                {
+                    if (elementCount > INLINE_CAPACITY) rehash(requiredCapacity > tableArrayCapacity ? requiredCapacity : tableArrayCapacity);
+                    return;
+                }
+            }
+            if (requiredCapacity > tableArrayCapacity) rehash(requiredCapacity);
+        }
 
-        // The hash function that will be used if one is not provided to
-        // the constructor.
-        // See: https://en.wikipedia.org/wiki/Jenkins_hash_function
-        static unsigned int jenkinsHashFunction(KEY_TYPE key, unsigned int modulus)
+        // Rebuilds the table array with at least the given number of buckets,
+        // or more if needed to keep the current elements within the maximum
+        // load factor. Nodes are relinked, not reallocated. An explicit
+        // rehash always runs to completion, even in incremental mode.
+        // Algorithmic runtime: O(N + buckets)
+        void rehash(size_t newCapacity)
         {
-            // Convert the key to a string
-            std::stringstream hashStringStream;
-            hashStringStream << key;
-            std::string hashString = hashStringStream.str();
+            // Finish any incremental rehash so that there is one table array
+            completeRehash();
 
-            // Compute the hash using the Jenkins hash function
-            unsigned int hash = 0;
-            for (unsigned int i = 0; hashString[i] != '\0'; i++)
+            // Never shrink below the size required by the maximum load factor
+            size_t minimumCapacity = (size_t)std::ceil(numberOfElements / maxLoadFactor);
+            if (newCapacity < minimumCapacity) newCapacity = minimumCapacity;
+            if (newCapacity == 0) newCapacity = 1;
+
+            // In small mode, allocate the table array at the new size
+            if constexpr (INLINE_CAPACITY > 0)
             {
-                hash += hashString[i];
-                hash += hash << 10;
-                hash ^= hash >> 6;
+                if (table == nullptr)
+                {
+                    this->tableArrayCapacity = newCapacity;
+                    leaveSmallMode();
+                    return;
+                }
             }
-            hash += hash << 3;
-            hash ^= hash >> 11;
-            hash += hash << 15;
+            if (newCapacity == tableArrayCapacity) return;
 
-            // Return the modulus of the hash
-            return hash % modulus;
+            // Allocate the new table array
+            HashTableNode<KEY_TYPE, VALUE_TYPE>** newTable = allocateTableArray(newCapacity);
+
+            // Move every node into its bucket in the new table array
+            for (size_t i = 0; i < this->tableArrayCapacity; i++) moveChain(table[i], newTable, newCapacity);
+
+            // Replace the old table array
+            freeTableArray(this->table);
+            this->table = newTable;
+            this->tableArrayCapacity = newCapacity;
         }
 
-        // The null pointer
-        int (*null)(KEY_TYPE) = nullptr;
+        // Returns statistics describing the memory held for the table's nodes
+        SlabAllocatorStatistics allocatorStatistics() const
+        {
+            return nodeAllocator.statistics();
+        }
 
-        // The size of the table array
-        size_t tableArrayCapacity;
+        // Turns incremental rehashing on or off. When it is on, growing the
+        // table allocates the new table array but leaves the nodes in the old
+        // one; each insert, remove, get and contains then moves up to
+        // bucketsPerStep buckets across (Redis style), and lookups check both
+        // table arrays until the move is complete. This bounds the cost of any
+        // single operation instead of stalling on a full rehash. Turning it
+        // off completes any rehash in progress.
+        void setIncrementalRehash(bool enabled, size_t bucketsPerStep = 4)
+        {
+            if (!enabled) completeRehash();
+            this->incrementalRehash = enabled;
+            this->rehashBucketsPerStep = bucketsPerStep == 0 ? 1 : bucketsPerStep;
+        }
 
-        // The number of elements in the table
-        size_t numberOfElements;
-};
+        // Returns true if an incremental rehash is in progress
+        bool isRehashing() const
+        {
+            return oldTable != nullptr;
+        }
+
+        // Returns true if the elements are held inline and the table array
+        // has not been allocated
+        bool isSmall() const
+        {
+            return table == nullptr;
+        }
+
+        // Moves every remaining bucket of an incremental rehash across at once
+        // Algorithmic runtime: O(N + buckets)
+        void completeRehash()
+        {
+            if (oldTable == nullptr) return;
+            while (rehashIndex < oldTableCapacity)
+            {
+                moveChain(oldTable[rehashIndex], table, tableArrayCapacity);
+                oldTable[rehashIndex] = nullptr;
+                rehashIndex++;
+            }
+            freeTableArray(oldTable);
+            oldTable = nullptr;
+        }
+
+        // Forward iterator over the elements of the table, in bucket order.
+        // An iterator walks the chains of the old table array, if an
+        // incremental rehash is in progress, and then those of the table
+        // array; in small mode it walks the inline nodes. Inserting and
+        // rehashing invalidate iterators, as does any operation that moves
+        // part of an incremental rehash along. Erasing an element through
+        // erase() invalidates only iterators to that element.
+        template<bool IS_CONST>
+        class Iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using difference_type = std::ptrdiff_t;
+                using value_type = HashTableEntryReference<KEY_TYPE, std::conditional_t<IS_CONST, const VALUE_TYPE, VALUE_TYPE>>;
+                using reference = value_type;
+                using pointer = value_type;
+
+                Iterator() = default;
+
+                // A const_iterator can be made from an iterator
+                template<bool OTHER_IS_CONST, typename = std::enable_if_t<IS_CONST && !OTHER_IS_CONST>>
+                Iterator(const Iterator<OTHER_IS_CONST>& other)
+                    : owner(other.owner), node(other.node), position(other.position)
+                {
+                }
+
+                reference operator*() const
+                {
+                    return {node->key, node->value};
+                }
+
+                pointer operator->() const
+                {
+                    return {node->key, node->value};
+                }
+
+                Iterator& operator++()
+                {
+                    if (owner->table != nullptr && node->next != nullptr)
+                    {
+                        node = node->next;
+                        return *this;
+                    }
+                    position++;
+                    node = owner->firstNodeFrom(position);
+                    return *this;
+                }
+
+                Iterator operator++(int)
+                {
+                    Iterator previous = *this;
+                    ++*this;
+                    return previous;
+                }
+
+                bool operator==(const Iterator& other) const
+                {
+                    return node == other.node;
+                }
+
+                bool operator!=(const Iterator& other) const
+                {
+                    return node != other.node;
+                }
+
+            private:
+                friend class HashTable;
+
+                // The table, the current node (null at the end), and the
+                // position of the node's bucket or inline slot
+                std::conditional_t<IS_CONST, const HashTable, HashTable>* owner = nullptr;
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* node = nullptr;
+                size_t position = 0;
+
+                Iterator(std::conditional_t<IS_CONST, const HashTable, HashTable>* owner, HashTableNode<KEY_TYPE, VALUE_TYPE>* node, size_t position)
+                    : owner(owner), node(node), position(position)
+                {
+                }
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        // Returns an iterator to the first element. Completes any incremental
+        // rehash first, so that lookups made while iterating move no nodes.
+        iterator begin()
+        {
+            completeRehash();
+            size_t position = 0;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = firstNodeFrom(position);
+            return iterator(this, node, position);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+
+        const_iterator begin() const
+        {
+            size_t position = 0;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = firstNodeFrom(position);
+            return const_iterator(this, node, position);
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator();
+        }
+
+        const_iterator cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator cend() const
+        {
+            return end();
+        }
+
+        // Removes the element an iterator refers to, returning an iterator to
+        // the element after it, so that elements can be erased while iterating:
+        //
+        //     for (auto it = table.begin(); it != table.end();)
+        //     {
+        //         if (expired(it->value)) it = table.erase(it);
+        //         else ++it;
+        //     }
+        //
+        // Algorithmic runtime: O(1) expected
+        iterator erase(const_iterator position)
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* target = position.node;
+
+            // In small mode the last inline node moves into the erased node's
+            // place, so it is the next element
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr)
+                {
+                    size_t index = position.position;
+                    removeInlineNode(target->key);
+                    return iterator(this, index < numberOfElements ? &inlineNodes.nodes()[index] : nullptr, index);
+                }
+            }
+
+            iterator next(this, target, position.position);
+            ++next;
+
+            // Unlink the node from its chain
+            HashTableNode<KEY_TYPE, VALUE_TYPE>** link = &bucketAt(position.position);
+            while (*link != target) link = &(*link)->next;
+            *link = target->next;
+            destroyNode(target);
+            numberOfElements--;
+            return next;
+        }
+
+        // Calls visit(key, value) for every element. Walks the buckets in
+        // order and prefetches the chains a few buckets ahead, which is faster
+        // than iterating when the work done per element is small.
+        // Algorithmic runtime: O(N + buckets)
+        template<typename VISIT_FUNCTION>
+        void forEach(VISIT_FUNCTION visit)
+        {
+            forEachNode([&](HashTableNode<KEY_TYPE, VALUE_TYPE>& node)
+            {
+                visit(static_cast<const KEY_TYPE&>(node.key), node.value);
+            });
+        }
+
+        template<typename VISIT_FUNCTION>
+        void forEach(VISIT_FUNCTION visit) const
+        {
+            forEachNode([&](const HashTableNode<KEY_TYPE, VALUE_TYPE>& node)
+            {
+                visit(node.key, node.value);
+            });
+        }
+
+    private:
+        // Merges shards by linking copies of their nodes into the table array directly
+        friend class ShardedHashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>;
+
+        // Reads every node, and the hash stored in it, when freezing a table
+        friend class FrozenHashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>;
+
+        // Reads every node, and the hash stored in it, when writing a mapped file
+        friend class MappedHashTableBuilder<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>;
+
+        // The hash table array, or null in small mode
+        HashTableNode<KEY_TYPE, VALUE_TYPE>** table;
+
+        // The nodes of a table in small mode, of which the first
+        // numberOfElements are constructed
+        HashTableInlineNodes<HashTableNode<KEY_TYPE, VALUE_TYPE>, INLINE_CAPACITY> inlineNodes;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // Builds the hasher for the first constructor
+        static HASH makeHasher(HashFunctionArgument hashFunction)
+        {
+            if constexpr (std::is_same<HASH, FunctionPointerHash<KEY_TYPE>>::value) return HASH(hashFunction);
+            else return HASH();
+        }
+
+        // Returns the full hash of the key
+        template<typename LOOKUP_KEY>
+        size_t hashKey(const LOOKUP_KEY& key) const
+        {
+            return hasher(key);
+        }
+
+        // Returns the index of the bucket that the key belongs in
+        template<typename LOOKUP_KEY>
+        size_t bucketIndex(const LOOKUP_KEY& key) const
+        {
+            return hashKey(key) % tableArrayCapacity;
+        }
+
+        // Hands out node storage from slabs owned by this table
+        SlabAllocator<HashTableNode<KEY_TYPE, VALUE_TYPE>> nodeAllocator;
+
+        // The table array that an incremental rehash is moving nodes out of,
+        // or null when no incremental rehash is in progress. Buckets before
+        // rehashIndex have already been moved.
+        HashTableNode<KEY_TYPE, VALUE_TYPE>** oldTable = nullptr;
+        size_t oldTableCapacity = 0;
+        size_t rehashIndex = 0;
+
+        // Whether growing the table rehashes incrementally, and the number of
+        // buckets moved by each operation while it does
+        bool incrementalRehash = false;
+        size_t rehashBucketsPerStep = 4;
+
+        // Doubles the size of the table array, either all at once or by
+        // starting an incremental rehash
+        void grow()
+        {
+            if (!incrementalRehash)
+            {
+                rehash(tableArrayCapacity * 2);
+                return;
+            }
+
+            // Only one incremental rehash can be in progress at a time
+            completeRehash();
+            oldTable = table;
+            oldTableCapacity = tableArrayCapacity;
+            rehashIndex = 0;
+            tableArrayCapacity *= 2;
+            table = allocateTableArray(tableArrayCapacity);
+        }
+
+        // Moves up to rehashBucketsPerStep non-empty buckets of an incremental
+        // rehash across, visiting at most ten times as many empty buckets
+        void rehashStep()
+        {
+            size_t bucketsLeft = rehashBucketsPerStep;
+            size_t emptyBucketsLeft = rehashBucketsPerStep * 10;
+            while (bucketsLeft > 0 && rehashIndex < oldTableCapacity)
+            {
+                if (oldTable[rehashIndex] == nullptr)
+                {
+                    rehashIndex++;
+                    if (--emptyBucketsLeft == 0) break;
+                    continue;
+                }
+                moveChain(oldTable[rehashIndex], table, tableArrayCapacity);
+                oldTable[rehashIndex] = nullptr;
+                rehashIndex++;
+                bucketsLeft--;
+            }
+
+            // The old table array is empty once every bucket has been moved
+            if (rehashIndex == oldTableCapacity)
+            {
+                freeTableArray(oldTable);
+                oldTable = nullptr;
+            }
+        }
+
+        // The most buckets loadSnapshot() gives a table, as a multiple of the
+        // number its elements need
+        static constexpr size_t SNAPSHOT_MAX_CAPACITY_FACTOR = 4;
+
+        // The fewest pairs that bulkBuild() hands to each thread
+        static constexpr size_t BULK_BUILD_MIN_ELEMENTS_PER_THREAD = 4096;
+
+        // Calls work(thread) for every thread index in [0, threadCount), on
+        // threadCount - 1 new threads and the calling thread. Waits for every
+        // call to finish, then returns the first exception thrown, if any.
+        template<typename WORK_FUNCTION>
+        static std::exception_ptr runOnThreads(size_t threadCount, WORK_FUNCTION work)
+        {
+            std::vector<std::exception_ptr> errors(threadCount);
+            auto guardedWork = [&](size_t thread)
+            {
+                try
+                {
+                    work(thread);
+                }
+                catch (...)
+                {
+                    errors[thread] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            try
+            {
+                threads.reserve(threadCount - 1);
+                for (size_t t = 1; t < threadCount; t++) threads.emplace_back(guardedWork, t);
+            }
+            catch (...)
+            {
+                // Run whatever could not be given a thread of its own here
+                for (size_t t = threads.size() + 1; t < threadCount; t++) guardedWork(t);
+            }
+            guardedWork(0);
+            for (std::thread& thread : threads) thread.join();
+
+            for (size_t t = 0; t < threadCount; t++)
+            {
+                if (errors[t]) return errors[t];
+            }
+            return nullptr;
+        }
+
+        // The number of keys that a batch lookup hashes and prefetches at a time
+        static constexpr size_t BATCH_LOOKUP_GROUP_SIZE = 64;
+
+        // Hints to the processor that the memory at the address will be read soon
+        static void prefetch(const void* address)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address);
+#else
+            (void)address;
+#endif
+        }
+
+        // Finds every key of a batch in groups of BATCH_LOOKUP_GROUP_SIZE,
+        // calling found(i, node) with the node of keys[i] or null. Each group
+        // runs in three passes: hash every key and prefetch its bucket, then
+        // prefetch the first node of every bucket, then walk every chain.
+        template<typename FOUND_CALLBACK>
+        void lookupBatch(const KEY_TYPE* keys, size_t count, FOUND_CALLBACK found)
+        {
+            // Move part of an incremental rehash along, once for the batch
+            if (oldTable != nullptr) rehashStep();
+
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr)
+                {
+                    for (size_t i = 0; i < count; i++) found(i, findInlineNode(keys[i]));
+                    return;
+                }
+            }
+
+            size_t hashes[BATCH_LOOKUP_GROUP_SIZE];
+            size_t buckets[BATCH_LOOKUP_GROUP_SIZE];
+            for (size_t groupStart = 0; groupStart < count; groupStart += BATCH_LOOKUP_GROUP_SIZE)
+            {
+                size_t groupSize = count - groupStart < BATCH_LOOKUP_GROUP_SIZE ? count - groupStart : BATCH_LOOKUP_GROUP_SIZE;
+
+                for (size_t i = 0; i < groupSize; i++)
+                {
+                    hashes[i] = hashKey(keys[groupStart + i]);
+                    buckets[i] = hashes[i] % tableArrayCapacity;
+                    prefetch(&table[buckets[i]]);
+                    if (oldTable != nullptr) prefetch(&oldTable[hashes[i] % oldTableCapacity]);
+                }
+
+                for (size_t i = 0; i < groupSize; i++)
+                {
+                    if (table[buckets[i]] != nullptr) prefetch(table[buckets[i]]);
+                    if (oldTable != nullptr && oldTable[hashes[i] % oldTableCapacity] != nullptr) prefetch(oldTable[hashes[i] % oldTableCapacity]);
+                }
+
+                for (size_t i = 0; i < groupSize; i++)
+                {
+                    found(groupStart + i, findNode(keys[groupStart + i], hashes[i]));
+                }
+            }
+        }
+
+        // Moves every node of a chain into its bucket in the given table
+        // array, using the hash stored in each node
+        void moveChain(HashTableNode<KEY_TYPE, VALUE_TYPE>* current, HashTableNode<KEY_TYPE, VALUE_TYPE>** destination, size_t destinationCapacity)
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* next;
+            while (current != nullptr)
+            {
+                next = current->next;
+                size_t bucket = current->hash % destinationCapacity;
+                current->next = destination[bucket];
+                destination[bucket] = current;
+                current = next;
+            }
+        }
+
+        // Finds or inserts the key as described for findOrInsert(). The key is
+        // forwarded into the node, so an rvalue key is moved rather than copied.
+        template<typename KEY_ARGUMENT, typename VALUE_FACTORY>
+        std::pair<VALUE_TYPE&, bool> findOrInsertKey(KEY_ARGUMENT&& key, VALUE_FACTORY&& valueFactory)
+        {
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
+
+            // In small mode, insert inline if there is room, otherwise leave small mode
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr)
+                {
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findInlineNode(key);
+                    if (node != nullptr) return {node->value, false};
+                    if (numberOfElements < INLINE_CAPACITY)
+                    {
+                        node = new (&inlineNodes.nodes()[numberOfElements]) HashTableNode<KEY_TYPE, VALUE_TYPE>{std::forward<KEY_ARGUMENT>(key), valueFactory(), nullptr, 0};
+                        numberOfElements++;
+                        return {node->value, true};
+                    }
+                    leaveSmallMode();
+                }
+            }
+
+            // Get the hash of the key
+            size_t hash = hashKey(key);
+
+            // Return the existing value if the key already exists
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findNode(key, hash);
+            if (node != nullptr) return {node->value, false};
+
+            // The key does not exist; grow the table array first if the new
+            // element would push the load factor past its maximum
+            if (numberOfElements + 1 > tableArrayCapacity * maxLoadFactor) grow();
+
+            // Create a new node at the head of its bucket, so that no second
+            // walk to the end of the chain is needed
+            node = createNode(std::forward<KEY_ARGUMENT>(key), hash, valueFactory);
+            size_t bucket = hash % tableArrayCapacity;
+            node->next = table[bucket];
+            table[bucket] = node;
+
+            // Increment the number of elements in the table
+            numberOfElements++;
+            return {node->value, true};
+        }
+
+        // Inserts or overwrites as described for insert(), forwarding the key
+        // and value so that each is copied or moved exactly once
+        template<typename KEY_ARGUMENT, typename VALUE_ARGUMENT>
+        void insertKeyValue(KEY_ARGUMENT&& key, VALUE_ARGUMENT&& value)
+        {
+            std::pair<VALUE_TYPE&, bool> result = findOrInsertKey(std::forward<KEY_ARGUMENT>(key), [&]() -> VALUE_ARGUMENT&& { return std::forward<VALUE_ARGUMENT>(value); });
+            if (!result.second) result.first = std::forward<VALUE_ARGUMENT>(value);
+        }
+
+        // The arguments are only used once: to construct the value of a new
+        // node, or to construct the value that overwrites an existing one
+        template<typename KEY_ARGUMENT, typename... VALUE_ARGUMENTS>
+        std::pair<VALUE_TYPE&, bool> emplaceKey(KEY_ARGUMENT&& key, VALUE_ARGUMENTS&&... valueArguments)
+        {
+            std::pair<VALUE_TYPE&, bool> result = findOrInsertKey(std::forward<KEY_ARGUMENT>(key), [&]() { return VALUE_TYPE(std::forward<VALUE_ARGUMENTS>(valueArguments)...); });
+            if (!result.second) result.first = VALUE_TYPE(std::forward<VALUE_ARGUMENTS>(valueArguments)...);
+            return result;
+        }
+
+        // Removes the node holding the key, returns false if there is none
+        template<typename LOOKUP_KEY>
+        bool removeKey(const LOOKUP_KEY& key)
+        {
+            // Move part of an incremental rehash along
+            if (oldTable != nullptr) rehashStep();
+
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr) return removeInlineNode(key);
+            }
+
+            // Get the hash of the key
+            size_t hash = hashKey(key);
+
+            // Search for the key in the old table array first, if there is one
+            if (oldTable != nullptr && removeFromBucket(oldTable[hash % oldTableCapacity], key, hash)) return true;
+            return removeFromBucket(table[hash % tableArrayCapacity], key, hash);
+        }
+
+        // Returns the node holding the key, or null if there is none
+        template<typename LOOKUP_KEY>
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* findNodeOfKey(const LOOKUP_KEY& key) const
+        {
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr) return findInlineNode(key);
+            }
+            return findNode(key, hashKey(key));
+        }
+
+        // Returns the inline node holding the key, or null if there is none
+        template<typename LOOKUP_KEY>
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* findInlineNode(const LOOKUP_KEY& key) const
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* nodes = const_cast<HashTableNode<KEY_TYPE, VALUE_TYPE>*>(inlineNodes.nodes());
+            for (size_t i = 0; i < numberOfElements; i++)
+            {
+                if (keyEqual(nodes[i].key, key)) return &nodes[i];
+            }
+            return nullptr;
+        }
+
+        // Removes the inline node holding the key by moving the last inline
+        // node into its place, returns false if no inline node holds the key
+        template<typename LOOKUP_KEY>
+        bool removeInlineNode(const LOOKUP_KEY& key)
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = findInlineNode(key);
+            if (node == nullptr) return false;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* last = &inlineNodes.nodes()[numberOfElements - 1];
+            node->~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+            if (node != last)
+            {
+                new (node) HashTableNode<KEY_TYPE, VALUE_TYPE>(std::move(*last));
+                last->~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+            }
+            numberOfElements--;
+            return true;
+        }
+
+        // Allocates the table array and moves every inline node into a node
+        // from the node allocator. Storage for every node is taken before any
+        // inline node is moved from, and nodes whose move could throw are
+        // copied, so a failure leaves the table in small mode unchanged.
+        void leaveSmallMode()
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* nodes = inlineNodes.nodes();
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* storage[INLINE_CAPACITY > 0 ? INLINE_CAPACITY : 1];
+            HashTableNode<KEY_TYPE, VALUE_TYPE>** newTable = nullptr;
+            size_t allocated = 0;
+            size_t constructed = 0;
+            try
+            {
+                newTable = allocateTableArray(tableArrayCapacity);
+                for (; allocated < numberOfElements; allocated++) storage[allocated] = nodeAllocator.allocate();
+                for (; constructed < numberOfElements; constructed++)
+                {
+                    size_t hash = hashKey(nodes[constructed].key);
+                    new (storage[constructed]) HashTableNode<KEY_TYPE, VALUE_TYPE>{std::move_if_noexcept(nodes[constructed].key), std::move_if_noexcept(nodes[constructed].value), nullptr, hash};
+                }
+            }
+            catch (...)
+            {
+                for (size_t i = 0; i < constructed; i++) storage[i]->~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+                for (size_t i = 0; i < allocated; i++) nodeAllocator.deallocate(storage[i]);
+                freeTableArray(newTable);
+                throw;
+            }
+
+            for (size_t i = 0; i < numberOfElements; i++)
+            {
+                nodes[i].~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+                size_t bucket = storage[i]->hash % tableArrayCapacity;
+                storage[i]->next = newTable[bucket];
+                newTable[bucket] = storage[i];
+            }
+            table = newTable;
+        }
+
+        // Returns the node holding the key in either table array, or null if there is none
+        template<typename LOOKUP_KEY>
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* findNode(const LOOKUP_KEY& key, size_t hash) const
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* current;
+            if (oldTable != nullptr)
+            {
+                current = oldTable[hash % oldTableCapacity];
+                while (current != nullptr)
+                {
+                    if (current->hash == hash && keyEqual(current->key, key)) return current;
+                    current = current->next;
+                }
+            }
+
+            current = table[hash % tableArrayCapacity];
+            while (current != nullptr)
+            {
+                if (current->hash == hash && keyEqual(current->key, key)) return current;
+                current = current->next;
+            }
+            return nullptr;
+        }
+
+        // Removes the node holding the key from a bucket, returns false if the bucket does not contain the key
+        template<typename LOOKUP_KEY>
+        bool removeFromBucket(HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucket, const LOOKUP_KEY& key, size_t hash)
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* current = bucket;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* previous = nullptr;
+            while (current != nullptr)
+            {
+                // Check if we have found the key
+                if (current->hash == hash && keyEqual(current->key, key))
+                {
+                    // The key exists, so remove its node
+                    if (previous == nullptr) bucket = current->next;
+                    else previous->next = current->next;
+                    destroyNode(current);
+                    numberOfElements--;
+                    return true;
+                }
+                previous = current;
+                current = current->next;
+            }
+            return false;
+        }
+
+        // Allocates a table array of empty buckets. calloc can hand back
+        // pages that are already zeroed, so a large table array costs little
+        // until its buckets are first touched, which keeps growth cheap for
+        // incremental rehashing.
+        static HashTableNode<KEY_TYPE, VALUE_TYPE>** allocateTableArray(size_t capacity)
+        {
+            void* tableArray = std::calloc(capacity, sizeof(HashTableNode<KEY_TYPE, VALUE_TYPE>*));
+            if (tableArray == nullptr) throw std::bad_alloc();
+            return static_cast<HashTableNode<KEY_TYPE, VALUE_TYPE>**>(tableArray);
+        }
+
+        static void freeTableArray(HashTableNode<KEY_TYPE, VALUE_TYPE>** tableArray)
+        {
+            std::free(tableArray);
+        }
+
+        // Creates a node in storage from the node allocator. The key is
+        // forwarded and the value is initialized directly from the result of
+        // valueFactory().
+        template<typename KEY_ARGUMENT, typename VALUE_FACTORY>
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* createNode(KEY_ARGUMENT&& key, size_t hash, VALUE_FACTORY& valueFactory)
+        {
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* node = nodeAllocator.allocate();
+            try
+            {
+                return new (node) HashTableNode<KEY_TYPE, VALUE_TYPE>{std::forward<KEY_ARGUMENT>(key), valueFactory(), nullptr, hash};
+            }
+            catch (...)
+            {
+                nodeAllocator.deallocate(node);
+                throw;
+            }
+        }
+
+        // Destroys a node and returns its storage to the node allocator
+        void destroyNode(HashTableNode<KEY_TYPE, VALUE_TYPE>* node)
+        {
+            node->~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+            nodeAllocator.deallocate(node);
+        }
+
+        // Destroys every node in a table array without freeing their storage
+        static void destroyChains(HashTableNode<KEY_TYPE, VALUE_TYPE>** tableArray, size_t capacity)
+        {
+            if (std::is_trivially_destructible<HashTableNode<KEY_TYPE, VALUE_TYPE>>::value) return;
+
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* current;
+            HashTableNode<KEY_TYPE, VALUE_TYPE>* next;
+            for (size_t i = 0; i < capacity; i++)
+            {
+                current = tableArray[i];
+                while (current != nullptr)
+                {
+                    next = current->next;
+                    current->~HashTableNode<KEY_TYPE, VALUE_TYPE>();
+                    current = next;
+                }
+            }
+        }
+
+        // The number of buckets ahead of the current one whose chains
+        // forEachNode() prefetches
+        static constexpr size_t FOR_EACH_PREFETCH_DISTANCE = 8;
+
+        // Calls visit(node) for every node in both table arrays, or for every
+        // inline node in small mode
+        template<typename VISIT_FUNCTION>
+        void forEachNode(VISIT_FUNCTION visit) const
+        {
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr)
+                {
+                    HashTableNode<KEY_TYPE, VALUE_TYPE>* nodes = const_cast<HashTableNode<KEY_TYPE, VALUE_TYPE>*>(inlineNodes.nodes());
+                    for (size_t i = 0; i < numberOfElements; i++) visit(nodes[i]);
+                    return;
+                }
+            }
+            if (oldTable != nullptr) forEachNodeInChains(oldTable, oldTableCapacity, visit);
+            forEachNodeInChains(table, tableArrayCapacity, visit);
+        }
+
+        template<typename VISIT_FUNCTION>
+        static void forEachNodeInChains(HashTableNode<KEY_TYPE, VALUE_TYPE>** tableArray, size_t capacity, VISIT_FUNCTION& visit)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (i + FOR_EACH_PREFETCH_DISTANCE < capacity && tableArray[i + FOR_EACH_PREFETCH_DISTANCE] != nullptr) prefetch(tableArray[i + FOR_EACH_PREFETCH_DISTANCE]);
+                for (HashTableNode<KEY_TYPE, VALUE_TYPE>* current = tableArray[i]; current != nullptr; current = current->next) visit(*current);
+            }
+        }
+
+        // Iterator positions number the buckets of the old table array, if
+        // there is one, followed by those of the table array, or the inline
+        // nodes in small mode. Returns the bucket at a position.
+        HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucketAt(size_t position) const
+        {
+            if (oldTable != nullptr)
+            {
+                if (position < oldTableCapacity) return oldTable[position];
+                position -= oldTableCapacity;
+            }
+            return table[position];
+        }
+
+        // Returns the first node at or after a position, moving the position
+        // to it, or null if there is none
+        HashTableNode<KEY_TYPE, VALUE_TYPE>* firstNodeFrom(size_t& position) const
+        {
+            if constexpr (INLINE_CAPACITY > 0)
+            {
+                if (table == nullptr) return position < numberOfElements ? const_cast<HashTableNode<KEY_TYPE, VALUE_TYPE>*>(&inlineNodes.nodes()[position]) : nullptr;
+            }
+            size_t positionCount = tableArrayCapacity + (oldTable != nullptr ? oldTableCapacity : 0);
+            for (; position < positionCount; position++)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* node = bucketAt(position);
+                if (node != nullptr) return node;
+            }
+            return nullptr;
+        }
+
+        static void printChains(HashTableNode<KEY_TYPE, VALUE_TYPE>** tableArray, size_t capacity, std::ostream& outputStream)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* current = tableArray[i];
+                while (current != nullptr)
+                {
+                    outputStream << current->key << ": " << current->value << std::endl;
+                    current = current->next;
+                }
+            }
+        }
+
+        // The null pointer
+        int (*null)(KEY_TYPE) = nullptr;
+
+        // The size of the table array
+        size_t tableArrayCapacity;
+
+        // The number of elements in the table
+        size_t numberOfElements;
+
+        // The load factor past which the table array grows
+        float maxLoadFactor;
+};
+
+// A hash table that keeps up to INLINE_CAPACITY elements inline before it
+// allocates anything, for maps that are usually tiny
+template<typename KEY_TYPE, typename VALUE_TYPE, size_t INLINE_CAPACITY = 8, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+using SmallHashTable = HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL, INLINE_CAPACITY>;
 
 #endif
\ No newline at end of file
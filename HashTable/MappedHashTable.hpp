@@ -0,0 +1,476 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file MappedHashTable.hpp
+ * @brief Read-only key/value dictionary served straight from a memory-mapped
+ * file, and a builder that writes such files from a HashTable. The file holds
+ * offsets rather than pointers, so opening one deserializes nothing, and
+ * processes that map the same file share its pages in the page cache.
+ * Requires POSIX mmap.
+ *
+ * Values must be trivially copyable. Keys must be trivially copyable or
+ * std::string; string keys are looked up by std::string_view and compared
+ * byte for byte. Pointers are rejected for both, since an address written by
+ * one process means nothing to another.
+ *
+ * A file is laid out as follows, with every number in the byte order of the
+ * machine that wrote it:
+ *
+ *     header      MappedHashTableHeader
+ *     buckets     uint64_t[bucketCount + 1], the index of the first entry of
+ *                 each bucket, followed by the number of entries
+ *     entries     MappedHashTableEntry[elementCount], grouped by bucket
+ *     strings     the bytes of every string key, referred to by offset
+ *
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef MAPPEDHASHTABLE_H
+#define MAPPEDHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "./HashFunctions.hpp"
+#include "./HashTable.hpp"
+#include "./SnapshotFile.hpp"
+
+struct MappedHashTableHeader
+{
+    // "SBMH", and the format version, which changes whenever the layout does
+    static constexpr uint32_t MAGIC = 0x484d4253;
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t keyEncoding;
+    uint32_t keySize;
+    uint32_t valueSize;
+    uint32_t entrySize;
+    uint64_t elementCount;
+    uint64_t bucketCount;
+    uint64_t bucketsOffset;
+    uint64_t entriesOffset;
+    uint64_t stringsOffset;
+    uint64_t fileSize;
+};
+
+// A string key, stored as the position of its bytes in the strings section
+struct MappedHashTableString
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
+template<typename STORED_KEY, typename VALUE_TYPE>
+struct MappedHashTableEntry
+{
+    uint64_t hash;
+    STORED_KEY key;
+    VALUE_TYPE value;
+};
+
+// How keys of one type are stored in a file (STORED_KEY) and handed to
+// lookups (KEY_VIEW)
+template<typename KEY_TYPE, typename = void>
+struct MappedHashTableKeyLayout
+{
+    static_assert(sizeof(KEY_TYPE) == 0, "Mapped hash table keys must be std::string or trivially copyable, and not pointers");
+};
+
+template<typename KEY_TYPE>
+struct MappedHashTableKeyLayout<KEY_TYPE, std::enable_if_t<std::is_trivially_copyable<KEY_TYPE>::value && !std::is_pointer<KEY_TYPE>::value>>
+{
+    using STORED_KEY = KEY_TYPE;
+    using KEY_VIEW = KEY_TYPE;
+    static constexpr uint32_t ENCODING = 1;
+
+    static size_t stringBytes(const KEY_TYPE&)
+    {
+        return 0;
+    }
+
+    static STORED_KEY store(const KEY_TYPE& key, uint64_t&)
+    {
+        return key;
+    }
+
+    static void writeString(SnapshotWriter&, const KEY_TYPE&) {}
+
+    static bool valid(const STORED_KEY&, uint64_t)
+    {
+        return true;
+    }
+
+    static const KEY_VIEW& view(const STORED_KEY& key, const char*)
+    {
+        return key;
+    }
+
+    template<typename KEY_EQUAL>
+    static bool equal(const KEY_EQUAL& keyEqual, const KEY_VIEW& stored, const KEY_VIEW& key)
+    {
+        return keyEqual(stored, key);
+    }
+};
+
+template<>
+struct MappedHashTableKeyLayout<std::string>
+{
+    using STORED_KEY = MappedHashTableString;
+    using KEY_VIEW = std::string_view;
+    static constexpr uint32_t ENCODING = 2;
+
+    static size_t stringBytes(const std::string& key)
+    {
+        return key.size();
+    }
+
+    // Returns the stored form of the key, whose bytes will be written at
+    // nextOffset in the strings section, and moves nextOffset past them
+    static STORED_KEY store(const std::string& key, uint64_t& nextOffset)
+    {
+        STORED_KEY stored{nextOffset, key.size()};
+        nextOffset += key.size();
+        return stored;
+    }
+
+    static void writeString(SnapshotWriter& writer, const std::string& key)
+    {
+        writer.write(key.data(), key.size());
+    }
+
+    static bool valid(const STORED_KEY& key, uint64_t stringsSize)
+    {
+        return key.offset <= stringsSize && key.length <= stringsSize - key.offset;
+    }
+
+    static KEY_VIEW view(const STORED_KEY& key, const char* strings)
+    {
+        return KEY_VIEW(strings + key.offset, key.length);
+    }
+
+    template<typename KEY_EQUAL>
+    static bool equal(const KEY_EQUAL&, KEY_VIEW stored, KEY_VIEW key)
+    {
+        return stored == key;
+    }
+};
+
+// Every section starts on a cache line
+static constexpr uint64_t MAPPED_HASH_TABLE_SECTION_ALIGNMENT = 64;
+
+// Writes the elements of a HashTable to a file that MappedHashTable can map.
+// The builder reads the table's nodes when it is constructed, reusing the
+// hashes stored in them, and refers to them until write() is called, so the
+// table must not change in between.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class MappedHashTableBuilder
+{
+    public:
+        using KEY_LAYOUT = MappedHashTableKeyLayout<KEY_TYPE>;
+        using ENTRY = MappedHashTableEntry<typename KEY_LAYOUT::STORED_KEY, VALUE_TYPE>;
+
+        static_assert(std::is_trivially_copyable<VALUE_TYPE>::value && !std::is_pointer<VALUE_TYPE>::value, "Mapped hash table values must be trivially copyable, and not pointers");
+
+        // Constructor
+        // Algorithmic runtime: O(N + buckets)
+        explicit MappedHashTableBuilder(const HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& source)
+        {
+            nodes.reserve(source.numberOfElements);
+            hashes.reserve(source.numberOfElements);
+            source.forEachNode([&](const HashTableNode<KEY_TYPE, VALUE_TYPE>& node)
+            {
+                nodes.push_back(&node);
+                hashes.push_back(node.hash);
+                stringBytes += KEY_LAYOUT::stringBytes(node.key);
+            });
+        }
+
+        // Writes the file, replacing any file at the given path once it is
+        // complete, so tables already mapped from the old file keep working.
+        // Elements are placed in one bucket per element, rounded up to a
+        // power of two.
+        // Throws std::runtime_error if the file cannot be written.
+        // Algorithmic runtime: O(N + buckets)
+        void write(const std::string& path) const
+        {
+            size_t elementCount = nodes.size();
+            size_t bucketCount = 1;
+            while (bucketCount < elementCount) bucketCount <<= 1;
+
+            // Counting sort of the elements by bucket
+            std::vector<uint64_t> bucketStarts(bucketCount + 1, 0);
+            for (size_t i = 0; i < elementCount; i++) bucketStarts[bucketOf(hashes[i], bucketCount) + 1]++;
+            for (size_t i = 0; i < bucketCount; i++) bucketStarts[i + 1] += bucketStarts[i];
+            std::vector<size_t> order(elementCount);
+            std::vector<uint64_t> nextInBucket(bucketStarts.begin(), bucketStarts.end() - 1);
+            for (size_t i = 0; i < elementCount; i++) order[nextInBucket[bucketOf(hashes[i], bucketCount)]++] = i;
+
+            MappedHashTableHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = MappedHashTableHeader::MAGIC;
+            header.version = MappedHashTableHeader::VERSION;
+            header.keyEncoding = KEY_LAYOUT::ENCODING;
+            header.keySize = sizeof(typename KEY_LAYOUT::STORED_KEY);
+            header.valueSize = sizeof(VALUE_TYPE);
+            header.entrySize = sizeof(ENTRY);
+            header.elementCount = elementCount;
+            header.bucketCount = bucketCount;
+            header.bucketsOffset = alignSection(sizeof(header));
+            header.entriesOffset = alignSection(header.bucketsOffset + bucketStarts.size() * sizeof(uint64_t));
+            header.stringsOffset = header.entriesOffset + elementCount * sizeof(ENTRY);
+            header.fileSize = header.stringsOffset + stringBytes;
+
+            SnapshotWriter writer(path);
+            uint64_t written = 0;
+            writeSection(writer, written, 0, &header, sizeof(header));
+            writeSection(writer, written, header.bucketsOffset, bucketStarts.data(), bucketStarts.size() * sizeof(uint64_t));
+            writePadding(writer, written, header.entriesOffset);
+
+            uint64_t nextStringOffset = 0;
+            alignas(ENTRY) unsigned char entryBytes[sizeof(ENTRY)];
+            for (size_t i : order)
+            {
+                // Zero the padding between members so that files are reproducible
+                std::memset(entryBytes, 0, sizeof(ENTRY));
+                new (entryBytes) ENTRY{hashes[i], KEY_LAYOUT::store(nodes[i]->key, nextStringOffset), nodes[i]->value};
+                writer.write(entryBytes, sizeof(ENTRY));
+            }
+            for (size_t i : order) KEY_LAYOUT::writeString(writer, nodes[i]->key);
+            writer.close();
+        }
+
+    private:
+        std::vector<const HashTableNode<KEY_TYPE, VALUE_TYPE>*> nodes;
+        std::vector<uint64_t> hashes;
+        uint64_t stringBytes = 0;
+
+        static size_t bucketOf(uint64_t hash, size_t bucketCount)
+        {
+            return mixHashBits(hash) & (bucketCount - 1);
+        }
+
+        static uint64_t alignSection(uint64_t offset)
+        {
+            return (offset + MAPPED_HASH_TABLE_SECTION_ALIGNMENT - 1) / MAPPED_HASH_TABLE_SECTION_ALIGNMENT * MAPPED_HASH_TABLE_SECTION_ALIGNMENT;
+        }
+
+        static void writePadding(SnapshotWriter& writer, uint64_t& written, uint64_t offset)
+        {
+            static const unsigned char zeros[MAPPED_HASH_TABLE_SECTION_ALIGNMENT] = {};
+            writer.write(zeros, offset - written);
+            written = offset;
+        }
+
+        static void writeSection(SnapshotWriter& writer, uint64_t& written, uint64_t offset, const void* data, size_t length)
+        {
+            writePadding(writer, written, offset);
+            writer.write(data, length);
+            written += length;
+        }
+};
+
+// Serves lookups from a file written by MappedHashTableBuilder, mapped read
+// only. Opening a file checks its header and nothing more, so it takes the
+// same time however large the file is; pages are read in as lookups touch
+// them. A lookup hashes the key once, reads the two offsets that bound its
+// bucket, and compares stored hashes before keys across the bucket's
+// entries, which are contiguous. Beyond the header and the first entry, the
+// contents of the file are trusted.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class MappedHashTable
+{
+    public:
+        using KEY_LAYOUT = MappedHashTableKeyLayout<KEY_TYPE>;
+        using KEY_VIEW = typename KEY_LAYOUT::KEY_VIEW;
+        using ENTRY = MappedHashTableEntry<typename KEY_LAYOUT::STORED_KEY, VALUE_TYPE>;
+
+        static_assert(std::is_trivially_copyable<VALUE_TYPE>::value && !std::is_pointer<VALUE_TYPE>::value, "Mapped hash table values must be trivially copyable, and not pointers");
+
+        // Constructor. Maps the file at the given path. Throws
+        // std::runtime_error if the file cannot be mapped, is not a mapped
+        // hash table file of this version, was written for other key or value
+        // types, or was written with another hash function.
+        // Algorithmic runtime: O(1)
+        explicit MappedHashTable(const std::string& path, HASH hasher = HASH(), KEY_EQUAL keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            int file = ::open(path.c_str(), O_RDONLY);
+            if (file < 0) throw std::runtime_error("Could not open mapped hash table file: " + path);
+            struct stat fileStatus;
+            if (::fstat(file, &fileStatus) != 0 || fileStatus.st_size < (off_t)sizeof(MappedHashTableHeader))
+            {
+                ::close(file);
+                throw std::runtime_error("Not a mapped hash table file: " + path);
+            }
+            mappingSize = (size_t)fileStatus.st_size;
+            void* address = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, file, 0);
+            ::close(file);
+            if (address == MAP_FAILED) throw std::runtime_error("Could not map hash table file: " + path);
+            mapping = static_cast<const char*>(address);
+
+            try
+            {
+                attach();
+            }
+            catch (...)
+            {
+                ::munmap(const_cast<char*>(mapping), mappingSize);
+                throw;
+            }
+
+            // Lookups touch pages in no particular order
+            ::madvise(const_cast<char*>(mapping), mappingSize, MADV_RANDOM);
+        }
+
+        MappedHashTable(MappedHashTable&& other) noexcept
+            : mapping(other.mapping), mappingSize(other.mappingSize), buckets(other.buckets), entries(other.entries), strings(other.strings), numberOfElements(other.numberOfElements), bucketMask(other.bucketMask), hasher(std::move(other.hasher)), keyEqual(std::move(other.keyEqual))
+        {
+            other.mapping = nullptr;
+            other.mappingSize = 0;
+            other.numberOfElements = 0;
+        }
+
+        MappedHashTable(const MappedHashTable&) = delete;
+        MappedHashTable& operator=(const MappedHashTable&) = delete;
+
+        // Destructor
+        ~MappedHashTable()
+        {
+            if (mapping != nullptr) ::munmap(const_cast<char*>(mapping), mappingSize);
+        }
+
+        // Returns a pointer to the value associated with the key, or null if
+        // the key does not exist. The value lives in the mapping.
+        // Algorithmic runtime: O(1) expected
+        const VALUE_TYPE* get(const KEY_VIEW& key) const
+        {
+            if (mapping == nullptr) return nullptr;
+            size_t hash = hasher(key);
+            size_t bucket = mixHashBits(hash) & bucketMask;
+            for (uint64_t i = buckets[bucket], end = buckets[bucket + 1]; i < end; i++)
+            {
+                const ENTRY& entry = entries[i];
+                if (entry.hash == (uint64_t)hash && KEY_LAYOUT::equal(keyEqual, KEY_LAYOUT::view(entry.key, strings), key)) return &entry.value;
+            }
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1) expected
+        bool contains(const KEY_VIEW& key) const
+        {
+            return get(key) != nullptr;
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Returns the number of buckets in the file
+        size_t bucketCount() const
+        {
+            return mapping == nullptr ? 0 : bucketMask + 1;
+        }
+
+        // Returns the size of the mapped file in bytes
+        size_t fileBytes() const
+        {
+            return mappingSize;
+        }
+
+        // Calls visit(key, value) for every element, in bucket order
+        template<typename VISIT_FUNCTION>
+        void forEach(VISIT_FUNCTION visit) const
+        {
+            for (size_t i = 0; i < numberOfElements; i++) visit(KEY_LAYOUT::view(entries[i].key, strings), entries[i].value);
+        }
+
+        // Prints the contents of the table to an output stream (the console by default)
+        void print(std::ostream& outputStream = std::cout) const
+        {
+            forEach([&](const KEY_VIEW& key, const VALUE_TYPE& value) { outputStream << key << ": " << value << std::endl; });
+        }
+
+    private:
+        const char* mapping = nullptr;
+        size_t mappingSize = 0;
+
+        // The sections of the mapping
+        const uint64_t* buckets = nullptr;
+        const ENTRY* entries = nullptr;
+        const char* strings = nullptr;
+
+        size_t numberOfElements = 0;
+        size_t bucketMask = 0;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // Checks the header against the file and the types of this table, and
+        // points the sections into the mapping
+        void attach()
+        {
+            MappedHashTableHeader header;
+            std::memcpy(&header, mapping, sizeof(header));
+            if (header.magic != MappedHashTableHeader::MAGIC) throw std::runtime_error("Not a mapped hash table file");
+            if (header.version != MappedHashTableHeader::VERSION) throw std::runtime_error("Unsupported mapped hash table version " + std::to_string(header.version));
+            if (header.keyEncoding != KEY_LAYOUT::ENCODING || header.keySize != sizeof(typename KEY_LAYOUT::STORED_KEY) || header.valueSize != sizeof(VALUE_TYPE) || header.entrySize != sizeof(ENTRY))
+            {
+                throw std::runtime_error("Mapped hash table file was written for other key or value types");
+            }
+
+            // Every section must lie within the file, in order
+            bool sectionsValid = header.fileSize == mappingSize
+                && header.bucketCount != 0 && (header.bucketCount & (header.bucketCount - 1)) == 0
+                && header.bucketsOffset >= sizeof(header) && header.bucketsOffset <= mappingSize && header.bucketsOffset % alignof(uint64_t) == 0
+                && header.bucketCount < (mappingSize - header.bucketsOffset) / sizeof(uint64_t)
+                && header.entriesOffset >= header.bucketsOffset + (header.bucketCount + 1) * sizeof(uint64_t) && header.entriesOffset % alignof(ENTRY) == 0
+                && header.entriesOffset <= mappingSize && header.elementCount <= (mappingSize - header.entriesOffset) / sizeof(ENTRY)
+                && header.stringsOffset >= header.entriesOffset + header.elementCount * sizeof(ENTRY) && header.stringsOffset <= mappingSize;
+            if (!sectionsValid) throw std::runtime_error("Mapped hash table file is truncated or corrupt");
+
+            buckets = reinterpret_cast<const uint64_t*>(mapping + header.bucketsOffset);
+            entries = reinterpret_cast<const ENTRY*>(mapping + header.entriesOffset);
+            strings = mapping + header.stringsOffset;
+            numberOfElements = (size_t)header.elementCount;
+            bucketMask = (size_t)header.bucketCount - 1;
+            if (buckets[header.bucketCount] != header.elementCount) throw std::runtime_error("Mapped hash table file is truncated or corrupt");
+
+            // The stored hashes are only usable with the hash function that
+            // produced them
+            if (numberOfElements > 0)
+            {
+                if (!KEY_LAYOUT::valid(entries[0].key, mappingSize - header.stringsOffset)) throw std::runtime_error("Mapped hash table file is truncated or corrupt");
+                if ((uint64_t)hasher(KEY_LAYOUT::view(entries[0].key, strings)) != entries[0].hash)
+                {
+                    throw std::runtime_error("Mapped hash table file was written with another hash function");
+                }
+            }
+        }
+};
+
+#endif
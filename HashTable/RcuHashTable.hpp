@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file RcuHashTable.hpp
+ * @brief Read-mostly hash table implementation of a key/value dictionary.
+ * Readers never take a lock or write to memory shared with other threads;
+ * writers publish changes read-copy-update style and free replaced memory
+ * after a grace period.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef RCUHASHTABLE_H
+#define RCUHASHTABLE_H
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include "./EpochReclaimer.hpp"
+#include "./HashFunctions.hpp"
+
+// Nodes are never modified once they are reachable. Writers, one at a time
+// under a mutex, build a new node or a new table array and publish it with a
+// single release store: an overwrite links a copy of the node in place of
+// the original, a removal links past the node, and growing the table copies
+// every chain into a new table array. Replaced memory is retired through the
+// EpochReclaimer and freed once every reader that could still see it has
+// finished (the grace period).
+//
+// A lookup pins the reading thread, which only writes that thread's own
+// record, and then walks one chain with acquire loads. Lookups never wait on
+// writers or retry, so they finish in a bounded number of steps.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class RcuHashTable
+{
+    public:
+        // Constructor. The table array grows once the load factor would
+        // exceed maxLoadFactor.
+        RcuHashTable(size_t tableSize = 100, float maxLoadFactor = 1.0f, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual), reclaimer(EpochReclaimer::instance())
+        {
+            if (!(maxLoadFactor > 0)) throw std::invalid_argument("The maximum load factor must be greater than zero");
+            this->maxLoadFactor = maxLoadFactor;
+            this->table.store(new TableArray(tableSize == 0 ? 1 : tableSize), std::memory_order_release);
+        }
+
+        RcuHashTable(const RcuHashTable&) = delete;
+        RcuHashTable& operator=(const RcuHashTable&) = delete;
+
+        // Destructor. No other thread may be using the table.
+        ~RcuHashTable()
+        {
+            destroyTableArray(table.load(std::memory_order_relaxed));
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            size_t hash = hasher(key);
+            std::lock_guard<std::mutex> lock(writerMutex);
+            TableArray* tableArray = table.load(std::memory_order_relaxed);
+
+            std::atomic<Node*>* link = findLink(tableArray, key, hash);
+            Node* node = link->load(std::memory_order_relaxed);
+            if (node != nullptr)
+            {
+                // Replace the node with an updated copy
+                link->store(new Node{key, value, hash, node->next.load(std::memory_order_relaxed)}, std::memory_order_release);
+                reclaimer.retire(node);
+                return;
+            }
+
+            // Grow first if the new element would push the load factor past its maximum
+            size_t numberOfElements = elementCount.load(std::memory_order_relaxed) + 1;
+            if (numberOfElements > tableArray->capacity * maxLoadFactor) tableArray = grow(tableArray);
+
+            std::atomic<Node*>& bucket = tableArray->buckets[hash % tableArray->capacity];
+            bucket.store(new Node{key, value, hash, bucket.load(std::memory_order_relaxed)}, std::memory_order_release);
+            elementCount.store(numberOfElements, std::memory_order_relaxed);
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t hash = hasher(key);
+            std::lock_guard<std::mutex> lock(writerMutex);
+            std::atomic<Node*>* link = findLink(table.load(std::memory_order_relaxed), key, hash);
+            Node* node = link->load(std::memory_order_relaxed);
+            if (node == nullptr) return false;
+
+            link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+            reclaimer.retire(node);
+            elementCount.store(elementCount.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Returns a copy of the value associated with the key, or nothing if the key does not exist
+        std::optional<VALUE_TYPE> get(const KEY_TYPE& key) const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            const Node* node = findNode(key);
+            if (node != nullptr) return node->value;
+            return std::nullopt;
+        }
+
+        // Calls reader(value) with the value associated with the key, without
+        // copying it. The reference is only valid during the call. Returns
+        // false if the key does not exist.
+        template<typename READ_FUNCTION>
+        bool read(const KEY_TYPE& key, READ_FUNCTION reader) const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            const Node* node = findNode(key);
+            if (node == nullptr) return false;
+            reader(node->value);
+            return true;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        bool contains(const KEY_TYPE& key) const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            return findNode(key) != nullptr;
+        }
+
+        // Clears all elements from the table. Readers still walking the old
+        // table array keep seeing it until they finish.
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            TableArray* oldTableArray = table.load(std::memory_order_relaxed);
+            table.store(new TableArray(oldTableArray->capacity), std::memory_order_release);
+            retireTableArray(oldTableArray);
+            elementCount.store(0, std::memory_order_relaxed);
+        }
+
+        // Returns the number of elements in the table
+        size_t size() const
+        {
+            return elementCount.load(std::memory_order_relaxed);
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Returns the number of buckets in the table array
+        size_t bucketCount() const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            return table.load(std::memory_order_acquire)->capacity;
+        }
+
+    private:
+        // A node is immutable once published, apart from writers relinking
+        // its successor
+        struct Node
+        {
+            KEY_TYPE key;
+            VALUE_TYPE value;
+            size_t hash;
+            std::atomic<Node*> next;
+        };
+
+        struct TableArray
+        {
+            size_t capacity;
+            std::atomic<Node*>* buckets;
+
+            explicit TableArray(size_t capacity)
+                : capacity(capacity), buckets(new std::atomic<Node*>[capacity]())
+            {
+            }
+
+            ~TableArray()
+            {
+                delete[] buckets;
+            }
+        };
+
+        // The published table array
+        std::atomic<TableArray*> table;
+
+        // The number of elements, only written by writers
+        std::atomic<size_t> elementCount{0};
+
+        // Serializes writers
+        std::mutex writerMutex;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The load factor past which the table array grows
+        float maxLoadFactor;
+
+        // Frees replaced memory after a grace period
+        EpochReclaimer& reclaimer;
+
+        // Returns the node holding the key, or null if there is none. The
+        // calling thread must be pinned.
+        const Node* findNode(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            const TableArray* tableArray = table.load(std::memory_order_acquire);
+            const Node* current = tableArray->buckets[hash % tableArray->capacity].load(std::memory_order_acquire);
+            while (current != nullptr)
+            {
+                if (current->hash == hash && keyEqual(current->key, key)) return current;
+                current = current->next.load(std::memory_order_acquire);
+            }
+            return nullptr;
+        }
+
+        // Returns the link that points to the node holding the key, or the
+        // null link at the end of its chain. Writers only.
+        std::atomic<Node*>* findLink(TableArray* tableArray, const KEY_TYPE& key, size_t hash)
+        {
+            std::atomic<Node*>* link = &tableArray->buckets[hash % tableArray->capacity];
+            Node* current = link->load(std::memory_order_relaxed);
+            while (current != nullptr)
+            {
+                if (current->hash == hash && keyEqual(current->key, key)) return link;
+                link = &current->next;
+                current = link->load(std::memory_order_relaxed);
+            }
+            return link;
+        }
+
+        // Publishes a copy of every chain in a table array twice the size,
+        // and returns it. Writers only.
+        TableArray* grow(TableArray* oldTableArray)
+        {
+            TableArray* newTableArray = new TableArray(oldTableArray->capacity * 2);
+            for (size_t i = 0; i < oldTableArray->capacity; i++)
+            {
+                Node* current = oldTableArray->buckets[i].load(std::memory_order_relaxed);
+                while (current != nullptr)
+                {
+                    std::atomic<Node*>& bucket = newTableArray->buckets[current->hash % newTableArray->capacity];
+                    bucket.store(new Node{current->key, current->value, current->hash, bucket.load(std::memory_order_relaxed)}, std::memory_order_relaxed);
+                    current = current->next.load(std::memory_order_relaxed);
+                }
+            }
+            table.store(newTableArray, std::memory_order_release);
+            retireTableArray(oldTableArray);
+            return newTableArray;
+        }
+
+        // Frees a table array and every node still linked into it once the
+        // grace period has passed
+        void retireTableArray(TableArray* tableArray)
+        {
+            reclaimer.retire(tableArray, [](void* retired) { destroyTableArray(static_cast<TableArray*>(retired)); });
+        }
+
+        static void destroyTableArray(TableArray* tableArray)
+        {
+            for (size_t i = 0; i < tableArray->capacity; i++)
+            {
+                Node* current = tableArray->buckets[i].load(std::memory_order_relaxed);
+                while (current != nullptr)
+                {
+                    Node* next = current->next.load(std::memory_order_relaxed);
+                    delete current;
+                    current = next;
+                }
+            }
+            delete tableArray;
+        }
+};
+
+#endif
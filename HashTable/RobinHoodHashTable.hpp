@@ -0,0 +1,375 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file RobinHoodHashTable.hpp
+ * @brief Open addressing hash table implementation of a key/value dictionary.
+ * Entries are stored inline and collisions are resolved with Robin Hood linear
+ * probing and backward shift deletion.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef ROBINHOODHASHTABLE_H
+#define ROBINHOODHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "./HashFunctions.hpp"
+
+template<typename KEY_TYPE, typename VALUE_TYPE>
+struct RobinHoodHashTableSlot
+{
+    KEY_TYPE key;
+    VALUE_TYPE value;
+};
+
+// Every slot has a one byte probe length alongside it: zero for an empty
+// slot, otherwise one more than the distance of its entry from the slot the
+// entry hashes to. An insert takes the slot of any entry that is closer to
+// its home slot than the new entry is ("robbing the rich"), which keeps probe
+// lengths short and uniform even at load factors of 0.9 and above, and lets a
+// lookup stop as soon as it reaches an entry closer to home than itself.
+//
+// Because a probe length must fit in its byte, no more than about 254 keys
+// can share one hash. Growing the table cannot separate such keys, so once a
+// probe sequence would overflow while the table is mostly empty, insert()
+// throws std::overflow_error rather than growing without end. A hash that
+// spreads keys reasonably never comes close; HashTable, whose chains have no
+// length limit, suits keys that cannot be hashed apart.
+//
+// Pointers returned by get() are invalidated by any insert or remove, since
+// entries move between slots.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class RobinHoodHashTable
+{
+    public:
+        // Constructor. The capacity is rounded up to a power of two, and the
+        // table grows once the load factor would exceed maxLoadFactor.
+        RobinHoodHashTable(size_t tableSize = 16, float maxLoadFactor = 0.9f, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            if (!(maxLoadFactor > 0 && maxLoadFactor <= 1)) throw std::invalid_argument("The maximum load factor must be greater than zero and at most one");
+            this->maxLoadFactor = maxLoadFactor;
+            allocateSlots(roundUpToPowerOfTwo(tableSize));
+        }
+
+        RobinHoodHashTable(const RobinHoodHashTable&) = delete;
+        RobinHoodHashTable& operator=(const RobinHoodHashTable&) = delete;
+
+        // Destructor
+        ~RobinHoodHashTable()
+        {
+            clear();
+            deallocateSlots();
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        // Throws std::overflow_error, leaving the table unchanged, if too
+        // many keys share the key's hash for its probe length to fit a byte.
+        // Algorithmic runtime: O(1) expected
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            // Walk the probe sequence until the key is found, or until an
+            // empty slot or an entry closer to its home slot shows that the key
+            // is not in the table
+            size_t index = hasher(key) & mask;
+            uint8_t probeLength = 1;
+            while (probeLengths[index] >= probeLength)
+            {
+                if (probeLengths[index] == probeLength && keyEqual(slots[index].key, key))
+                {
+                    slots[index].value = value;
+                    return;
+                }
+                index = (index + 1) & mask;
+                probeLength++;
+            }
+
+            // The key does not exist; grow first if the new element would push
+            // the load factor past its maximum, or if placing it could push an
+            // entry's probe length past what a byte can hold
+            RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE> newSlot{key, value};
+            if (numberOfElements + 1 > capacity * maxLoadFactor)
+            {
+                rehash(capacity * 2);
+                findInsertionPoint(newSlot.key, index, probeLength);
+            }
+            while (placementCouldOverflow(index, probeLength))
+            {
+                growToShortenProbes();
+                findInsertionPoint(newSlot.key, index, probeLength);
+            }
+            placeSlot(index, probeLength, std::move(newSlot));
+            numberOfElements++;
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        // Algorithmic runtime: O(1) expected
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t index;
+            if (!findIndex(key, index)) return false;
+
+            // Shift each following entry that is away from its home slot back
+            // by one, so that no tombstone is left behind
+            slots[index].~RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            size_t next = (index + 1) & mask;
+            while (probeLengths[next] > 1)
+            {
+                new (&slots[index]) RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>(std::move(slots[next]));
+                slots[next].~RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+                probeLengths[index] = probeLengths[next] - 1;
+                index = next;
+                next = (next + 1) & mask;
+            }
+            probeLengths[index] = 0;
+            numberOfElements--;
+            return true;
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1) expected
+        VALUE_TYPE* get(const KEY_TYPE& key)
+        {
+            size_t index;
+            if (findIndex(key, index)) return &slots[index].value;
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1) expected
+        bool contains(const KEY_TYPE& key)
+        {
+            size_t index;
+            return findIndex(key, index);
+        }
+
+        // Clears all elements from the table. Does not shrink the slot array.
+        // Algorithmic runtime: O(capacity)
+        void clear()
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (probeLengths[i] == 0) continue;
+                slots[i].~RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+                probeLengths[i] = 0;
+            }
+            numberOfElements = 0;
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Prints the contents of the table to an output stream (the console by default)
+        void print(std::ostream& outputStream = std::cout)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (probeLengths[i] == 0) continue;
+                outputStream << slots[i].key << ": " << slots[i].value << std::endl;
+            }
+        }
+
+        // Returns the number of slots in the table
+        size_t bucketCount() const
+        {
+            return capacity;
+        }
+
+        // Returns the fraction of slots that are occupied
+        float loadFactor() const
+        {
+            return (float)numberOfElements / capacity;
+        }
+
+        // Returns the load factor past which the table grows
+        float getMaxLoadFactor() const
+        {
+            return maxLoadFactor;
+        }
+
+        // Grows the table so that it can hold at least the given number of
+        // elements without exceeding the maximum load factor
+        void reserve(size_t elementCount)
+        {
+            size_t requiredCapacity = roundUpToPowerOfTwo((size_t)(elementCount / maxLoadFactor) + 1);
+            if (requiredCapacity > capacity) rehash(requiredCapacity);
+        }
+
+    private:
+        // Probe lengths are stored in a byte; an entry that would reach this
+        // probe length forces the table to grow instead, so lookups can never
+        // probe past it
+        static constexpr uint8_t MAX_PROBE_LENGTH = 255;
+
+        // The slot array and the probe length of each slot
+        RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>* slots;
+        uint8_t* probeLengths;
+        std::allocator<RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>> slotAllocator;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The size of the slot array (a power of two) and the mask that
+        // reduces a hash to a slot index
+        size_t capacity;
+        size_t mask;
+
+        // The number of elements in the table
+        size_t numberOfElements = 0;
+
+        // The load factor past which the table grows
+        float maxLoadFactor;
+
+        static size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t powerOfTwo = 8;
+            while (powerOfTwo < value) powerOfTwo *= 2;
+            return powerOfTwo;
+        }
+
+        void allocateSlots(size_t newCapacity)
+        {
+            slots = slotAllocator.allocate(newCapacity);
+            probeLengths = new uint8_t[newCapacity]();
+            capacity = newCapacity;
+            mask = newCapacity - 1;
+        }
+
+        void deallocateSlots()
+        {
+            slotAllocator.deallocate(slots, capacity);
+            delete[] probeLengths;
+        }
+
+        // Finds the slot holding the key, returning false if there is none
+        bool findIndex(const KEY_TYPE& key, size_t& index) const
+        {
+            index = hasher(key) & mask;
+            uint8_t probeLength = 1;
+            while (probeLengths[index] >= probeLength)
+            {
+                if (probeLengths[index] == probeLength && keyEqual(slots[index].key, key)) return true;
+                index = (index + 1) & mask;
+                probeLength++;
+            }
+            return false;
+        }
+
+        // Finds the position in the probe sequence where a key that is known
+        // not to be in the table belongs
+        void findInsertionPoint(const KEY_TYPE& key, size_t& index, uint8_t& probeLength) const
+        {
+            index = hasher(key) & mask;
+            probeLength = 1;
+            while (probeLengths[index] >= probeLength)
+            {
+                index = (index + 1) & mask;
+                probeLength++;
+            }
+        }
+
+        // Returns true if placing an entry at the given position could carry
+        // some entry to MAX_PROBE_LENGTH. A carried entry only reaches it by
+        // meeting an entry one short of it before the next empty slot.
+        bool placementCouldOverflow(size_t index, uint8_t probeLength) const
+        {
+            if (probeLength == MAX_PROBE_LENGTH) return true;
+            while (probeLengths[index] != 0)
+            {
+                if (probeLengths[index] == MAX_PROBE_LENGTH - 1) return true;
+                index = (index + 1) & mask;
+            }
+            return false;
+        }
+
+        // Places an entry whose key is known not to be in the table
+        void placeNewSlot(RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>&& slot)
+        {
+            size_t index;
+            uint8_t probeLength;
+            findInsertionPoint(slot.key, index, probeLength);
+            placeSlot(index, probeLength, std::move(slot));
+        }
+
+        // Places an entry at the given position of its probe sequence,
+        // displacing entries that are closer to their home slots down the
+        // table until an empty slot is reached
+        void placeSlot(size_t index, uint8_t probeLength, RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>&& slot)
+        {
+            RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE> carried(std::move(slot));
+            while (true)
+            {
+                // The carried entry has run out of probe length; every other
+                // entry is in place, so grow and place it again. Inserts check
+                // for this beforehand, so only a rehash can get here.
+                if (probeLength == MAX_PROBE_LENGTH)
+                {
+                    rehash(capacity * 2);
+                    placeNewSlot(std::move(carried));
+                    return;
+                }
+
+                if (probeLengths[index] == 0) break;
+                if (probeLengths[index] < probeLength)
+                {
+                    std::swap(carried, slots[index]);
+                    std::swap(probeLength, probeLengths[index]);
+                }
+                index = (index + 1) & mask;
+                probeLength++;
+            }
+            new (&slots[index]) RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>(std::move(carried));
+            probeLengths[index] = probeLength;
+        }
+
+        // Doubles the capacity of the table because a probe length would not
+        // fit its byte. Only called before an insert modifies the table, so
+        // the table is unchanged if it throws. Growth for the load factor
+        // does not come here, since a maxLoadFactor below 1/8 keeps the
+        // table that empty on purpose.
+        void growToShortenProbes()
+        {
+            // A long probe sequence in a mostly empty table means many keys
+            // share a hash, which growing will not fix
+            if (loadFactor() < 0.125f) throw std::overflow_error("Too many keys in the table share the same hash");
+            rehash(capacity * 2);
+        }
+
+        // Moves every entry into a new slot array of the given capacity
+        void rehash(size_t newCapacity)
+        {
+            RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>* oldSlots = slots;
+            uint8_t* oldProbeLengths = probeLengths;
+            size_t oldCapacity = capacity;
+            allocateSlots(newCapacity);
+
+            for (size_t i = 0; i < oldCapacity; i++)
+            {
+                if (oldProbeLengths[i] == 0) continue;
+                placeNewSlot(std::move(oldSlots[i]));
+                oldSlots[i].~RobinHoodHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            }
+
+            slotAllocator.deallocate(oldSlots, oldCapacity);
+            delete[] oldProbeLengths;
+        }
+};
+
+#endif
@@ -0,0 +1,255 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file ShardedHashTable.hpp
+ * @brief A set of private HashTable shards, one per worker thread, that are
+ * filled without synchronization and then merged into one HashTable in
+ * parallel.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef SHARDEDHASHTABLE_H
+#define SHARDEDHASHTABLE_H
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "./HashFunctions.hpp"
+#include "./HashTable.hpp"
+
+// Each worker thread inserts into its own shard, so ingest needs no locks and
+// shares no cache lines. While no thread is writing, the shards can be read
+// together as one table, and merge() combines them into a single HashTable.
+//
+// merge() runs in two parallel passes. First every shard is partitioned by
+// the destination bucket of each node, using the hash stored in the node, so
+// no key is hashed again. Then each thread copies the nodes of one partition,
+// a contiguous range of destination buckets, into new nodes that it links
+// straight into the destination's table array. No two threads touch the same
+// bucket, so neither pass takes a lock, and each thread allocates nodes from
+// a slab allocator of its own. The shards keep their elements; clear() them
+// to release that memory.
+//
+// When a key is held by more than one shard, its values are combined in shard
+// order; by default the value from the highest numbered shard wins.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class ShardedHashTable
+{
+    public:
+        // Constructor. Creates shardCount shards of shardTableSize buckets.
+        ShardedHashTable(size_t shardCount, size_t shardTableSize = 100, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            if (shardCount == 0) throw std::invalid_argument("A sharded hash table must have at least one shard");
+            shards.reserve(shardCount);
+            for (size_t i = 0; i < shardCount; i++) shards.emplace_back(new HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>(shardTableSize, hasher, keyEqual));
+        }
+
+        // Returns the shard with the given index. Each shard must only be
+        // used by one thread at a time.
+        HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& shard(size_t index)
+        {
+            if (index >= shards.size()) throw std::out_of_range("Shard index out of range");
+            return *shards[index];
+        }
+
+        // Returns the number of shards
+        size_t shardCount() const
+        {
+            return shards.size();
+        }
+
+        // Returns a pointer to the value associated with the key in the
+        // highest numbered shard that holds it, or null if no shard holds the
+        // key. No thread may be writing to any shard.
+        const VALUE_TYPE* get(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            for (size_t i = shards.size(); i > 0; i--)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* node = shards[i - 1]->findNode(key, hash);
+                if (node != nullptr) return &node->value;
+            }
+            return nullptr;
+        }
+
+        // Returns the values associated with the key in every shard that
+        // holds it, combined in shard order by combine(combined, next), or
+        // nothing if no shard holds the key. No thread may be writing to any
+        // shard.
+        template<typename COMBINE_FUNCTION>
+        std::optional<VALUE_TYPE> get(const KEY_TYPE& key, COMBINE_FUNCTION combine) const
+        {
+            size_t hash = hasher(key);
+            std::optional<VALUE_TYPE> combined;
+            for (size_t i = 0; i < shards.size(); i++)
+            {
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* node = shards[i]->findNode(key, hash);
+                if (node == nullptr) continue;
+                if (combined) combine(*combined, node->value);
+                else combined = node->value;
+            }
+            return combined;
+        }
+
+        // Returns true if any shard holds the key. No thread may be writing to
+        // any shard.
+        bool contains(const KEY_TYPE& key) const
+        {
+            size_t hash = hasher(key);
+            for (size_t i = 0; i < shards.size(); i++)
+            {
+                if (shards[i]->findNode(key, hash) != nullptr) return true;
+            }
+            return false;
+        }
+
+        // Returns the total number of elements in every shard. A key held by
+        // several shards is counted once per shard.
+        size_t size() const
+        {
+            size_t numberOfElements = 0;
+            for (size_t i = 0; i < shards.size(); i++) numberOfElements += shards[i]->numberOfElements;
+            return numberOfElements;
+        }
+
+        // Returns true if every shard is empty
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Clears every shard
+        void clear()
+        {
+            for (size_t i = 0; i < shards.size(); i++) shards[i]->clear();
+        }
+
+        // Copies every element of every shard into destination on threadCount
+        // threads, keeping the value from the highest numbered shard for keys
+        // held by several shards. Elements already in destination count as
+        // coming before shard 0. The shards are left unchanged. No thread may
+        // be writing to any shard.
+        void merge(HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& destination, size_t threadCount = 0)
+        {
+            merge(destination, [](VALUE_TYPE& combined, const VALUE_TYPE& next) { combined = next; }, threadCount);
+        }
+
+        // Copies every element of every shard into destination on threadCount
+        // threads (all hardware threads if 0). When a key is held by several
+        // shards, or is already in destination, combine(combined, next) is
+        // called to fold each later value into the earlier one, in shard
+        // order. No thread may be writing to any shard.
+        //
+        // Nodes are placed by the hashes stored in the shards, so destination
+        // must hash keys exactly as this table's hasher does; with a seeded
+        // or otherwise stateful HASH (such as a FunctionPointerHash), build
+        // it from the same instance. Throws std::invalid_argument if
+        // destination hashes the first key of the shards differently.
+        template<typename COMBINE_FUNCTION>
+        void merge(HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& destination, COMBINE_FUNCTION combine, size_t threadCount = 0)
+        {
+            // Stored hashes are only comparable if destination hashes keys the same way
+            for (size_t i = 0; i < shards.size(); i++)
+            {
+                size_t position = 0;
+                HashTableNode<KEY_TYPE, VALUE_TYPE>* first = shards[i]->firstNodeFrom(position);
+                if (first == nullptr) continue;
+                if (destination.hashKey(first->key) != first->hash) throw std::invalid_argument("Cannot merge into a hash table whose hasher hashes keys differently from the shards");
+                break;
+            }
+            if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+            if (threadCount == 0) threadCount = 1;
+
+            // Size the destination for the worst case so that it never grows
+            // while nodes are being linked into it
+            for (size_t i = 0; i < shards.size(); i++) shards[i]->completeRehash();
+            destination.reserve(destination.size() + size());
+            destination.completeRehash();
+            size_t capacity = destination.tableArrayCapacity;
+            if (threadCount > capacity) threadCount = capacity;
+            size_t bucketsPerPartition = (capacity + threadCount - 1) / threadCount;
+
+            // Pass 1: partition the nodes of every shard by destination bucket
+            // range. partitions[shard * threadCount + partition] lists the
+            // nodes of one shard that belong to one partition.
+            std::vector<std::vector<HashTableNode<KEY_TYPE, VALUE_TYPE>*>> partitions(shards.size() * threadCount);
+            std::exception_ptr error = HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>::runOnThreads(threadCount, [&](size_t thread)
+            {
+                for (size_t s = thread; s < shards.size(); s += threadCount)
+                {
+                    HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>& source = *shards[s];
+                    for (size_t i = 0; i < source.tableArrayCapacity; i++)
+                    {
+                        for (HashTableNode<KEY_TYPE, VALUE_TYPE>* node = source.table[i]; node != nullptr; node = node->next)
+                        {
+                            partitions[s * threadCount + (node->hash % capacity) / bucketsPerPartition].push_back(node);
+                        }
+                    }
+                }
+            });
+            if (error) std::rethrow_exception(error);
+
+            // Pass 2: copy each partition's nodes into new nodes linked into
+            // its own range of destination buckets, visiting the shards in order
+            std::vector<std::unique_ptr<SlabAllocator<HashTableNode<KEY_TYPE, VALUE_TYPE>>>> allocators(threadCount);
+            std::vector<size_t> insertedCounts(threadCount, 0);
+            for (size_t t = 0; t < threadCount; t++) allocators[t].reset(new SlabAllocator<HashTableNode<KEY_TYPE, VALUE_TYPE>>());
+            error = HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>::runOnThreads(threadCount, [&](size_t thread)
+            {
+                for (size_t s = 0; s < shards.size(); s++)
+                {
+                    for (HashTableNode<KEY_TYPE, VALUE_TYPE>* source : partitions[s * threadCount + thread])
+                    {
+                        HashTableNode<KEY_TYPE, VALUE_TYPE>*& bucket = destination.table[source->hash % capacity];
+                        HashTableNode<KEY_TYPE, VALUE_TYPE>* existing = bucket;
+                        while (existing != nullptr && !(existing->hash == source->hash && keyEqual(existing->key, source->key))) existing = existing->next;
+                        if (existing != nullptr)
+                        {
+                            combine(existing->value, source->value);
+                            continue;
+                        }
+
+                        HashTableNode<KEY_TYPE, VALUE_TYPE>* node = allocators[thread]->allocate();
+                        try
+                        {
+                            new (node) HashTableNode<KEY_TYPE, VALUE_TYPE>{source->key, source->value, bucket, source->hash};
+                        }
+                        catch (...)
+                        {
+                            allocators[thread]->deallocate(node);
+                            throw;
+                        }
+                        bucket = node;
+                        insertedCounts[thread]++;
+                    }
+                }
+            });
+
+            // Hand the new nodes to the destination, even if a copy failed
+            for (size_t t = 0; t < threadCount; t++)
+            {
+                destination.nodeAllocator.absorb(*allocators[t]);
+                destination.numberOfElements += insertedCounts[t];
+            }
+            if (error) std::rethrow_exception(error);
+        }
+
+    private:
+        // The shards. Each is allocated separately so that shards used by
+        // different threads do not share cache lines.
+        std::vector<std::unique_ptr<HashTable<KEY_TYPE, VALUE_TYPE, HASH, KEY_EQUAL>>> shards;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+};
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SlabAllocator.hpp
+ * @brief Fixed-size object allocator that hands out objects from large
+ * contiguous slabs and reuses freed objects through a free list.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+#include <cstddef>
+#include <vector>
+
+struct SlabAllocatorStatistics
+{
+    // The number of slabs currently held
+    size_t slabCount;
+
+    // The number of objects that the held slabs have room for
+    size_t objectCapacity;
+
+    // The number of objects currently handed out
+    size_t objectsInUse;
+
+    // The number of freed objects waiting on the free list to be reused
+    size_t freeListLength;
+
+    // The number of bytes held in slabs
+    size_t bytesReserved;
+
+    // The total number of objects handed out since construction
+    size_t totalAllocations;
+};
+
+// Allocates storage for objects of type T. Storage is carved out of slabs in
+// order, freed storage is pushed onto a free list and handed out again first,
+// and release() frees every slab at once. Each slab is twice the size of the
+// one before it, up to maxObjectsPerSlab, so small users stay small and large
+// users make few calls to the system allocator. Objects are not constructed
+// or destroyed by the allocator.
+template<typename T>
+class SlabAllocator
+{
+    public:
+        // Constructor
+        SlabAllocator(size_t firstSlabSize = 16, size_t maxObjectsPerSlab = 4096)
+        {
+            this->nextSlabSize = firstSlabSize == 0 ? 1 : firstSlabSize;
+            this->maxObjectsPerSlab = maxObjectsPerSlab < this->nextSlabSize ? this->nextSlabSize : maxObjectsPerSlab;
+        }
+
+        SlabAllocator(const SlabAllocator&) = delete;
+        SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+        // Destructor; frees every slab
+        ~SlabAllocator()
+        {
+            release();
+        }
+
+        // Returns uninitialized storage for one object
+        // Algorithmic runtime: O(1) amortized
+        T* allocate()
+        {
+            Slot* slot;
+            if (freeList != nullptr)
+            {
+                slot = freeList;
+                freeList = freeList->nextFree;
+                freeListLength--;
+            }
+            else
+            {
+                if (nextUnused == slabEnd) addSlab();
+                slot = nextUnused++;
+            }
+            objectsInUse++;
+            totalAllocations++;
+            return reinterpret_cast<T*>(slot->storage);
+        }
+
+        // Returns the storage for one object to the free list. The object must
+        // already have been destroyed.
+        // Algorithmic runtime: O(1)
+        void deallocate(T* object)
+        {
+            Slot* slot = reinterpret_cast<Slot*>(object);
+            slot->nextFree = freeList;
+            freeList = slot;
+            freeListLength++;
+            objectsInUse--;
+        }
+
+        // Frees every slab at once. Every object must already have been
+        // destroyed; none of their storage may be used afterwards.
+        // Algorithmic runtime: O(slabs)
+        void release()
+        {
+            for (size_t i = 0; i < slabs.size(); i++) delete[] slabs[i];
+            slabs.clear();
+            freeList = nullptr;
+            nextUnused = nullptr;
+            slabEnd = nullptr;
+            objectCapacity = 0;
+            objectsInUse = 0;
+            freeListLength = 0;
+        }
+
+        // Takes ownership of every slab held by another allocator, along with
+        // the objects handed out from them, leaving the other allocator
+        // empty. Lets several threads allocate from allocators of their own
+        // and hand the results to one owner afterwards.
+        // Algorithmic runtime: O(slabs + free list length of other)
+        void absorb(SlabAllocator& other)
+        {
+            if (&other == this) return;
+            slabs.reserve(slabs.size() + other.slabs.size());
+            slabs.insert(slabs.end(), other.slabs.begin(), other.slabs.end());
+
+            // The unused tail of the other allocator's newest slab is kept on
+            // the free list rather than lost
+            while (other.nextUnused != other.slabEnd)
+            {
+                Slot* slot = other.nextUnused++;
+                slot->nextFree = other.freeList;
+                other.freeList = slot;
+                other.freeListLength++;
+            }
+            while (other.freeList != nullptr)
+            {
+                Slot* slot = other.freeList;
+                other.freeList = slot->nextFree;
+                slot->nextFree = freeList;
+                freeList = slot;
+            }
+
+            objectCapacity += other.objectCapacity;
+            objectsInUse += other.objectsInUse;
+            freeListLength += other.freeListLength;
+            totalAllocations += other.totalAllocations;
+
+            other.slabs.clear();
+            other.nextUnused = nullptr;
+            other.slabEnd = nullptr;
+            other.objectCapacity = 0;
+            other.objectsInUse = 0;
+            other.freeListLength = 0;
+            other.totalAllocations = 0;
+        }
+
+        // Returns statistics describing the memory held by the allocator
+        SlabAllocatorStatistics statistics() const
+        {
+            SlabAllocatorStatistics result;
+            result.slabCount = slabs.size();
+            result.objectCapacity = objectCapacity;
+            result.objectsInUse = objectsInUse;
+            result.freeListLength = freeListLength;
+            result.bytesReserved = objectCapacity * sizeof(Slot);
+            result.totalAllocations = totalAllocations;
+            return result;
+        }
+
+    private:
+        // Storage for one object, which holds the next free slot while it is
+        // on the free list
+        union Slot
+        {
+            Slot* nextFree;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        // Every slab held, and the range of the newest slab not yet handed out
+        std::vector<Slot*> slabs;
+        Slot* nextUnused = nullptr;
+        Slot* slabEnd = nullptr;
+
+        // Freed slots, most recently freed first
+        Slot* freeList = nullptr;
+
+        // The size of the next slab to allocate, and the largest slab size
+        size_t nextSlabSize;
+        size_t maxObjectsPerSlab;
+
+        // Counters reported by statistics()
+        size_t objectCapacity = 0;
+        size_t objectsInUse = 0;
+        size_t freeListLength = 0;
+        size_t totalAllocations = 0;
+
+        void addSlab()
+        {
+            Slot* slab = new Slot[nextSlabSize];
+            try
+            {
+                slabs.push_back(slab);
+            }
+            catch (...)
+            {
+                delete[] slab;
+                throw;
+            }
+            nextUnused = slab;
+            slabEnd = slab + nextSlabSize;
+            objectCapacity += nextSlabSize;
+            if (nextSlabSize < maxObjectsPerSlab) nextSlabSize = nextSlabSize * 2 < maxObjectsPerSlab ? nextSlabSize * 2 : maxObjectsPerSlab;
+        }
+};
+
+#endif
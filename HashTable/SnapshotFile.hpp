@@ -0,0 +1,334 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SnapshotFile.hpp
+ * @brief Buffered binary file reading and writing for hash table snapshots,
+ * and the codecs that encode keys and values in them.
+ *
+ * Trivially copyable types other than pointers are written as their bytes,
+ * and std::string as its length followed by its characters. To snapshot a
+ * table with another key or value type, specialize SnapshotCodec for it:
+ *
+ *     template<>
+ *     struct SnapshotCodec<Point>
+ *     {
+ *         static constexpr uint32_t ENCODING = 100;
+ *         static constexpr uint32_t SIZE = 0;
+ *         static void write(SnapshotWriter& writer, const Point& point) { ... }
+ *         static Point read(SnapshotReader& reader) { ... }
+ *     };
+ *
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef SNAPSHOTFILE_H
+#define SNAPSHOTFILE_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Collects writes in a buffer and writes the buffer to the file whenever it
+// fills, so that a snapshot is written in a few large blocks however small
+// its elements are. The file is written beside the destination, at the path
+// with ".tmp" appended, and only renamed over it by close(), so a crash or
+// a throw part way through leaves any earlier file at the path intact.
+// Throws std::runtime_error if the file cannot be opened or written.
+class SnapshotWriter
+{
+    public:
+        explicit SnapshotWriter(const std::string& path)
+            : path(path), temporaryPath(path + ".tmp"), file(std::fopen(temporaryPath.c_str(), "wb"))
+        {
+            if (file == nullptr) throw std::runtime_error("Could not open snapshot file for writing: " + temporaryPath);
+            buffer.reserve(BUFFER_SIZE);
+        }
+
+        SnapshotWriter(const SnapshotWriter&) = delete;
+        SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+        // Destructor. Discards the temporary file if close() was not reached.
+        ~SnapshotWriter()
+        {
+            if (file != nullptr)
+            {
+                std::fclose(file);
+                std::remove(temporaryPath.c_str());
+            }
+        }
+
+        void write(const void* data, size_t length)
+        {
+            if (buffer.size() + length > BUFFER_SIZE) flush();
+            if (length > BUFFER_SIZE)
+            {
+                writeToFile(data, length);
+                return;
+            }
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            buffer.insert(buffer.end(), bytes, bytes + length);
+        }
+
+        template<typename VALUE_TYPE>
+        void writeValue(const VALUE_TYPE& value)
+        {
+            static_assert(std::is_trivially_copyable<VALUE_TYPE>::value, "Only trivially copyable values can be written as bytes");
+            write(&value, sizeof(VALUE_TYPE));
+        }
+
+        // Writes out anything left in the buffer, closes the file and moves
+        // it to the destination path. A snapshot is only complete once this
+        // returns.
+        void close()
+        {
+            flush();
+            int result = std::fclose(file);
+            file = nullptr;
+            if (result != 0 || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+            {
+                std::remove(temporaryPath.c_str());
+                throw std::runtime_error("Could not write snapshot file: " + path);
+            }
+        }
+
+    private:
+        static constexpr size_t BUFFER_SIZE = (size_t)1 << 20;
+
+        std::string path;
+        std::string temporaryPath;
+        std::FILE* file;
+        std::vector<unsigned char> buffer;
+
+        void flush()
+        {
+            if (buffer.empty()) return;
+            writeToFile(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        void writeToFile(const void* data, size_t length)
+        {
+            if (std::fwrite(data, 1, length, file) != length) throw std::runtime_error("Could not write snapshot file");
+        }
+};
+
+// Reads a file through a buffer that is refilled in large blocks. Throws
+// std::runtime_error if the file cannot be opened or ends too soon.
+class SnapshotReader
+{
+    public:
+        explicit SnapshotReader(const std::string& path)
+            : file(std::fopen(path.c_str(), "rb"))
+        {
+            if (file == nullptr) throw std::runtime_error("Could not open snapshot file for reading: " + path);
+            long length = -1;
+            if (std::fseek(file, 0, SEEK_END) == 0) length = std::ftell(file);
+            if (length < 0 || std::fseek(file, 0, SEEK_SET) != 0)
+            {
+                std::fclose(file);
+                throw std::runtime_error("Could not read snapshot file: " + path);
+            }
+            size = (uint64_t)length;
+            buffer.resize(BUFFER_SIZE);
+        }
+
+        SnapshotReader(const SnapshotReader&) = delete;
+        SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+        ~SnapshotReader()
+        {
+            std::fclose(file);
+        }
+
+        void read(void* data, size_t length)
+        {
+            unsigned char* bytes = static_cast<unsigned char*>(data);
+            while (length > 0)
+            {
+                if (position == available) refill();
+                size_t chunk = available - position < length ? available - position : length;
+                std::memcpy(bytes, buffer.data() + position, chunk);
+                position += chunk;
+                bytes += chunk;
+                length -= chunk;
+            }
+        }
+
+        // Returns the size of the file in bytes
+        uint64_t fileSize() const
+        {
+            return size;
+        }
+
+        // Returns the number of bytes of the file not yet read
+        uint64_t remainingBytes() const
+        {
+            return size - (bytesFetched - (available - position));
+        }
+
+        template<typename VALUE_TYPE>
+        VALUE_TYPE readValue()
+        {
+            static_assert(std::is_trivially_copyable<VALUE_TYPE>::value, "Only trivially copyable values can be read as bytes");
+            alignas(VALUE_TYPE) unsigned char bytes[sizeof(VALUE_TYPE)];
+            read(bytes, sizeof(VALUE_TYPE));
+            return *std::launder(reinterpret_cast<VALUE_TYPE*>(bytes));
+        }
+
+    private:
+        static constexpr size_t BUFFER_SIZE = (size_t)1 << 20;
+
+        std::FILE* file;
+        uint64_t size = 0;
+        std::vector<unsigned char> buffer;
+        size_t position = 0;
+        size_t available = 0;
+
+        // The number of bytes fetched from the file into the buffer so far
+        uint64_t bytesFetched = 0;
+
+        void refill()
+        {
+            available = std::fread(buffer.data(), 1, buffer.size(), file);
+            position = 0;
+            bytesFetched += available;
+            if (available == 0) throw std::runtime_error("Snapshot file is truncated");
+        }
+};
+
+// Encodes keys and values of one type in a snapshot. ENCODING identifies the
+// encoding and SIZE the size of a fixed-size encoding, or zero; both are
+// checked when a snapshot is loaded.
+template<typename TYPE, typename = void>
+struct SnapshotCodec
+{
+    static_assert(sizeof(TYPE) == 0, "Specialize SnapshotCodec to snapshot this key or value type");
+};
+
+// Pointers are trivially copyable, but an address means nothing to the
+// process that loads the snapshot, so they are left to the static_assert
+template<typename TYPE>
+struct SnapshotCodec<TYPE, std::enable_if_t<std::is_trivially_copyable<TYPE>::value && !std::is_pointer<TYPE>::value>>
+{
+    static constexpr uint32_t ENCODING = 1;
+    static constexpr uint32_t SIZE = sizeof(TYPE);
+
+    static void write(SnapshotWriter& writer, const TYPE& value)
+    {
+        writer.writeValue(value);
+    }
+
+    static TYPE read(SnapshotReader& reader)
+    {
+        return reader.readValue<TYPE>();
+    }
+};
+
+template<>
+struct SnapshotCodec<std::string>
+{
+    static constexpr uint32_t ENCODING = 2;
+    static constexpr uint32_t SIZE = 0;
+
+    static void write(SnapshotWriter& writer, const std::string& value)
+    {
+        writer.writeValue((uint64_t)value.size());
+        writer.write(value.data(), value.size());
+    }
+
+    // Throws std::runtime_error if the length runs past the end of the
+    // file, before allocating anything for it
+    static std::string read(SnapshotReader& reader)
+    {
+        uint64_t length = reader.readValue<uint64_t>();
+        if (length > reader.remainingBytes()) throw std::runtime_error("Hash table snapshot file is truncated or corrupt");
+        std::string value(length, '\0');
+        reader.read(&value[0], value.size());
+        return value;
+    }
+};
+
+// The header at the start of every snapshot. A snapshot holds numbers in the
+// byte order of the machine that wrote it.
+struct SnapshotHeader
+{
+    // "SBHT", and the format version, which changes whenever the layout does
+    static constexpr uint32_t MAGIC = 0x54484253;
+    static constexpr uint32_t VERSION = 1;
+
+    // The size of a header in the file
+    static constexpr uint64_t BYTES = 6 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint32_t keyEncoding = 0;
+    uint32_t keySize = 0;
+    uint32_t valueEncoding = 0;
+    uint32_t valueSize = 0;
+    uint64_t elementCount = 0;
+    uint64_t bucketCount = 0;
+
+    template<typename KEY_TYPE, typename VALUE_TYPE>
+    static SnapshotHeader describe(uint64_t elementCount, uint64_t bucketCount)
+    {
+        SnapshotHeader header;
+        header.keyEncoding = SnapshotCodec<KEY_TYPE>::ENCODING;
+        header.keySize = SnapshotCodec<KEY_TYPE>::SIZE;
+        header.valueEncoding = SnapshotCodec<VALUE_TYPE>::ENCODING;
+        header.valueSize = SnapshotCodec<VALUE_TYPE>::SIZE;
+        header.elementCount = elementCount;
+        header.bucketCount = bucketCount;
+        return header;
+    }
+
+    void write(SnapshotWriter& writer) const
+    {
+        writer.writeValue(magic);
+        writer.writeValue(version);
+        writer.writeValue(keyEncoding);
+        writer.writeValue(keySize);
+        writer.writeValue(valueEncoding);
+        writer.writeValue(valueSize);
+        writer.writeValue(elementCount);
+        writer.writeValue(bucketCount);
+    }
+
+    // Reads a header, throwing std::runtime_error if the file is not a
+    // snapshot of this version, was written for other key or value types, or
+    // is too short to hold the number of elements the header claims
+    template<typename KEY_TYPE, typename VALUE_TYPE>
+    static SnapshotHeader read(SnapshotReader& reader)
+    {
+        SnapshotHeader header;
+        header.magic = reader.readValue<uint32_t>();
+        if (header.magic != MAGIC) throw std::runtime_error("Not a hash table snapshot file");
+        header.version = reader.readValue<uint32_t>();
+        if (header.version != VERSION) throw std::runtime_error("Unsupported hash table snapshot version " + std::to_string(header.version));
+        header.keyEncoding = reader.readValue<uint32_t>();
+        header.keySize = reader.readValue<uint32_t>();
+        header.valueEncoding = reader.readValue<uint32_t>();
+        header.valueSize = reader.readValue<uint32_t>();
+        header.elementCount = reader.readValue<uint64_t>();
+        header.bucketCount = reader.readValue<uint64_t>();
+
+        SnapshotHeader expected = describe<KEY_TYPE, VALUE_TYPE>(0, 0);
+        if (header.keyEncoding != expected.keyEncoding || header.keySize != expected.keySize || header.valueEncoding != expected.valueEncoding || header.valueSize != expected.valueSize)
+        {
+            throw std::runtime_error("Hash table snapshot was written for other key or value types");
+        }
+
+        // Every element takes at least its hash and any fixed-size key and value
+        uint64_t minimumElementBytes = sizeof(uint64_t) + header.keySize + header.valueSize;
+        if (header.elementCount > (reader.fileSize() - BYTES) / minimumElementBytes) throw std::runtime_error("Hash table snapshot file is truncated or corrupt");
+        return header;
+    }
+};
+
+#endif
@@ -0,0 +1,475 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SplitOrderedHashTable.hpp
+ * @brief Lock-free hash table implementation of a key/value dictionary using
+ * recursive split ordering (Shalev and Shavit). Every element sits in one
+ * lock-free sorted linked list, and the buckets point into that list, so the
+ * table grows without ever moving a node.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef SPLITORDEREDHASHTABLE_H
+#define SPLITORDEREDHASHTABLE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include "./EpochReclaimer.hpp"
+#include "./HashFunctions.hpp"
+
+// The list is sorted by the bit-reversed hash of each key ("split order"), so
+// the elements of bucket b, for a table of any power-of-two size, form one
+// run of the list. Each bucket starts with a sentinel node that is inserted
+// the first time the bucket is used, just after the sentinel of its parent
+// bucket (b with its highest bit cleared). Doubling the bucket count therefore
+// splits every bucket in two without touching any element.
+//
+// Nodes are unlinked with the Harris-Michael marked-pointer scheme and are
+// freed through the EpochReclaimer once no thread can still be reading them.
+// Values live in their own heap cells so that overwriting a value is a single
+// atomic pointer exchange, and values are returned by copy.
+//
+// insert, remove, get and contains never block; a thread that is delayed at
+// any point cannot stop other threads from making progress.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class SplitOrderedHashTable
+{
+    public:
+        // Constructor. The bucket count is rounded up to a power of two and
+        // doubles once the load factor would exceed maxLoadFactor.
+        SplitOrderedHashTable(size_t tableSize = 16, float maxLoadFactor = 2.0f, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual), reclaimer(EpochReclaimer::instance())
+        {
+            if (!(maxLoadFactor > 0)) throw std::invalid_argument("The maximum load factor must be greater than zero");
+            this->maxLoadFactor = maxLoadFactor;
+
+            size_t capacity = 1;
+            while (capacity < tableSize && capacity < MAX_BUCKET_COUNT) capacity *= 2;
+            this->tableArrayCapacity.store(capacity, std::memory_order_relaxed);
+
+            // Bucket 0 holds the head of the list and is never uninitialized
+            ListNode* head = new ListNode();
+            bucketSlot(0).store(head, std::memory_order_release);
+        }
+
+        SplitOrderedHashTable(const SplitOrderedHashTable&) = delete;
+        SplitOrderedHashTable& operator=(const SplitOrderedHashTable&) = delete;
+
+        // Destructor. No other thread may be using the table.
+        ~SplitOrderedHashTable()
+        {
+            ListNode* current = bucketSlot(0).load(std::memory_order_relaxed);
+            while (current != nullptr)
+            {
+                ListNode* next = pointerOf(current->next.load(std::memory_order_relaxed));
+                destroyNode(current);
+                current = next;
+            }
+            for (size_t i = 0; i < SEGMENT_COUNT; i++) delete[] segments[i].load(std::memory_order_relaxed);
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            size_t hash = hasher(key);
+            uint64_t orderKey = entryOrderKey(hash);
+            ListNode* head = bucketHead(hash);
+            VALUE_TYPE* valueCell = new VALUE_TYPE(value);
+            EntryNode* node = nullptr;
+
+            Window window;
+            while (true)
+            {
+                if (find(head, orderKey, &key, hash, window))
+                {
+                    // Publish the new value and retire the one it replaces
+                    VALUE_TYPE* oldValue = static_cast<EntryNode*>(window.found)->value.exchange(valueCell, std::memory_order_acq_rel);
+                    reclaimer.retire(oldValue);
+
+                    // A node built on an earlier attempt was never published
+                    if (node != nullptr)
+                    {
+                        node->value.store(nullptr, std::memory_order_relaxed);
+                        delete node;
+                    }
+                    return;
+                }
+
+                if (node == nullptr) node = new EntryNode(orderKey, hash, key, valueCell);
+                node->next.store(reinterpret_cast<uintptr_t>(window.current), std::memory_order_relaxed);
+                uintptr_t expected = reinterpret_cast<uintptr_t>(window.current);
+                if (window.previousLink->compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(node), std::memory_order_release, std::memory_order_relaxed)) break;
+            }
+
+            // Double the bucket count once the load factor passes its maximum.
+            // Buckets of the larger table are initialized as they are used.
+            size_t numberOfElements = elementCount.fetch_add(1, std::memory_order_relaxed) + 1;
+            size_t capacity = tableArrayCapacity.load(std::memory_order_relaxed);
+            if (numberOfElements > capacity * maxLoadFactor && capacity < MAX_BUCKET_COUNT)
+            {
+                tableArrayCapacity.compare_exchange_strong(capacity, capacity * 2, std::memory_order_relaxed);
+            }
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        bool remove(const KEY_TYPE& key)
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            size_t hash = hasher(key);
+            uint64_t orderKey = entryOrderKey(hash);
+            ListNode* head = bucketHead(hash);
+
+            Window window;
+            while (find(head, orderKey, &key, hash, window))
+            {
+                if (markAndUnlink(head, window)) return true;
+            }
+            return false;
+        }
+
+        // Returns a copy of the value associated with the key, or nothing if the key does not exist
+        std::optional<VALUE_TYPE> get(const KEY_TYPE& key) const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            size_t hash = hasher(key);
+            EntryNode* node = findEntry(key, hash);
+            if (node != nullptr) return *node->value.load(std::memory_order_acquire);
+            return std::nullopt;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        bool contains(const KEY_TYPE& key) const
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            return findEntry(key, hasher(key)) != nullptr;
+        }
+
+        // Removes every element from the table. Elements inserted by other
+        // threads while the table is being cleared may remain.
+        void clear()
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            ListNode* head = bucketSlot(0).load(std::memory_order_acquire);
+
+            // Mark every element removed, then unlink them all in one pass
+            ListNode* current = pointerOf(head->next.load(std::memory_order_acquire));
+            while (current != nullptr)
+            {
+                uintptr_t next = current->next.load(std::memory_order_acquire);
+                if (isEntry(current) && !isMarked(next) && current->next.compare_exchange_strong(next, next | MARK_BIT, std::memory_order_acq_rel))
+                {
+                    elementCount.fetch_sub(1, std::memory_order_relaxed);
+                }
+                current = pointerOf(current->next.load(std::memory_order_acquire));
+            }
+            Window window;
+            find(head, UINT64_MAX, nullptr, 0, window);
+        }
+
+        // Returns the number of elements in the table. While other threads are
+        // modifying the table this is only a snapshot.
+        size_t size() const
+        {
+            return elementCount.load(std::memory_order_relaxed);
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // Returns the number of buckets in the table
+        size_t bucketCount() const
+        {
+            return tableArrayCapacity.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // The low bit of a link marks the node holding it as removed
+        static constexpr uintptr_t MARK_BIT = 1;
+
+        // Buckets live in segments that are allocated as they are first used.
+        // Segment 0 holds bucket 0 and segment s holds buckets [2^(s-1), 2^s),
+        // so no bucket ever moves.
+        static constexpr size_t SEGMENT_COUNT = 64;
+        static constexpr size_t MAX_BUCKET_COUNT = (size_t)1 << (SEGMENT_COUNT - 1);
+
+        // A sentinel node at the start of a bucket. Sentinels have even order
+        // keys and are never removed.
+        struct ListNode
+        {
+            std::atomic<uintptr_t> next{0};
+            uint64_t orderKey = 0;
+
+            ListNode() = default;
+
+            explicit ListNode(uint64_t orderKey)
+                : orderKey(orderKey)
+            {
+            }
+        };
+
+        // A node holding an element. Elements have odd order keys.
+        struct EntryNode : ListNode
+        {
+            size_t hash;
+            KEY_TYPE key;
+            std::atomic<VALUE_TYPE*> value;
+
+            EntryNode(uint64_t orderKey, size_t hash, const KEY_TYPE& key, VALUE_TYPE* value)
+                : ListNode(orderKey), hash(hash), key(key), value(value)
+            {
+            }
+
+            ~EntryNode()
+            {
+                delete value.load(std::memory_order_relaxed);
+            }
+        };
+
+        // The result of a search: the link at which a new node would be
+        // inserted and the node it points to, and the node holding the key
+        // along with the link that points to it
+        struct Window
+        {
+            std::atomic<uintptr_t>* previousLink;
+            ListNode* current;
+            std::atomic<uintptr_t>* foundLink;
+            ListNode* found;
+        };
+
+        // The bucket segments
+        mutable std::atomic<std::atomic<ListNode*>*> segments[SEGMENT_COUNT] = {};
+
+        // The number of buckets (a power of two) and the number of elements
+        std::atomic<size_t> tableArrayCapacity;
+        alignas(64) std::atomic<size_t> elementCount{0};
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The load factor past which the bucket count doubles
+        float maxLoadFactor;
+
+        // Frees unlinked nodes once no reader can still see them
+        EpochReclaimer& reclaimer;
+
+        static ListNode* pointerOf(uintptr_t link)
+        {
+            return reinterpret_cast<ListNode*>(link & ~MARK_BIT);
+        }
+
+        static bool isMarked(uintptr_t link)
+        {
+            return (link & MARK_BIT) != 0;
+        }
+
+        static bool isEntry(const ListNode* node)
+        {
+            return (node->orderKey & 1) != 0;
+        }
+
+        static void destroyNode(ListNode* node)
+        {
+            if (isEntry(node)) delete static_cast<EntryNode*>(node);
+            else delete node;
+        }
+
+        static uint64_t reverseBits(uint64_t value)
+        {
+            value = ((value >> 1) & 0x5555555555555555ULL) | ((value & 0x5555555555555555ULL) << 1);
+            value = ((value >> 2) & 0x3333333333333333ULL) | ((value & 0x3333333333333333ULL) << 2);
+            value = ((value >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((value & 0x0f0f0f0f0f0f0f0fULL) << 4);
+            value = ((value >> 8) & 0x00ff00ff00ff00ffULL) | ((value & 0x00ff00ff00ff00ffULL) << 8);
+            value = ((value >> 16) & 0x0000ffff0000ffffULL) | ((value & 0x0000ffff0000ffffULL) << 16);
+            return (value >> 32) | (value << 32);
+        }
+
+        // Elements are ordered by their reversed hash with the lowest bit set,
+        // after the sentinel of their bucket (the reversed bucket index)
+        static uint64_t entryOrderKey(size_t hash)
+        {
+            return reverseBits((uint64_t)hash) | 1;
+        }
+
+        static uint64_t sentinelOrderKey(size_t bucket)
+        {
+            return reverseBits((uint64_t)bucket);
+        }
+
+        // Returns the number of bits needed to represent the bucket index
+        static size_t bitWidth(size_t bucket)
+        {
+            if (bucket == 0) return 0;
+#if defined(__GNUC__) || defined(__clang__)
+            return 64 - (size_t)__builtin_clzll((unsigned long long)bucket);
+#else
+            size_t width = 0;
+            while (bucket != 0)
+            {
+                bucket >>= 1;
+                width++;
+            }
+            return width;
+#endif
+        }
+
+        // Returns the slot that points to the sentinel of a bucket, allocating
+        // its segment if needed
+        std::atomic<ListNode*>& bucketSlot(size_t bucket) const
+        {
+            size_t segmentIndex = bitWidth(bucket);
+            size_t segmentStart = segmentIndex == 0 ? 0 : (size_t)1 << (segmentIndex - 1);
+            std::atomic<ListNode*>* segment = segments[segmentIndex].load(std::memory_order_acquire);
+            if (segment == nullptr)
+            {
+                size_t segmentSize = segmentIndex == 0 ? 1 : segmentStart;
+                std::atomic<ListNode*>* newSegment = new std::atomic<ListNode*>[segmentSize]();
+                if (segments[segmentIndex].compare_exchange_strong(segment, newSegment, std::memory_order_acq_rel, std::memory_order_acquire)) segment = newSegment;
+                else delete[] newSegment;
+            }
+            return segment[bucket - segmentStart];
+        }
+
+        // Returns the sentinel of the bucket for a hash
+        ListNode* bucketHead(size_t hash) const
+        {
+            return sentinelOf(hash & (tableArrayCapacity.load(std::memory_order_relaxed) - 1));
+        }
+
+        // Returns the sentinel of a bucket, inserting it into the list first
+        // if this is the first time the bucket has been used
+        ListNode* sentinelOf(size_t bucket) const
+        {
+            std::atomic<ListNode*>& slot = bucketSlot(bucket);
+            ListNode* sentinel = slot.load(std::memory_order_acquire);
+            if (sentinel != nullptr) return sentinel;
+
+            // The sentinel goes into the list after the parent bucket's
+            // sentinel; another thread may get there first
+            ListNode* parent = sentinelOf(bucket & ~((size_t)1 << (bitWidth(bucket) - 1)));
+            ListNode* newSentinel = new ListNode(sentinelOrderKey(bucket));
+            Window window;
+            while (true)
+            {
+                if (find(parent, newSentinel->orderKey, nullptr, 0, window))
+                {
+                    delete newSentinel;
+                    sentinel = window.found;
+                    break;
+                }
+                newSentinel->next.store(reinterpret_cast<uintptr_t>(window.current), std::memory_order_relaxed);
+                uintptr_t expected = reinterpret_cast<uintptr_t>(window.current);
+                if (window.previousLink->compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(newSentinel), std::memory_order_release, std::memory_order_relaxed))
+                {
+                    sentinel = newSentinel;
+                    break;
+                }
+            }
+            slot.store(sentinel, std::memory_order_release);
+            return sentinel;
+        }
+
+        // Returns the node holding the key, or null if there is none
+        EntryNode* findEntry(const KEY_TYPE& key, size_t hash) const
+        {
+            Window window;
+            if (find(bucketHead(hash), entryOrderKey(hash), &key, hash, window)) return static_cast<EntryNode*>(window.found);
+            return nullptr;
+        }
+
+        // Searches the list from a sentinel for the node with the order key
+        // and, for elements, the key. A null key searches for a sentinel.
+        // Unlinks and retires every removed node it passes. Returns true if
+        // the node was found. The calling thread must be pinned.
+        bool find(ListNode* head, uint64_t orderKey, const KEY_TYPE* key, size_t hash, Window& window) const
+        {
+        retry:
+            std::atomic<uintptr_t>* previousLink = &head->next;
+            ListNode* current = pointerOf(previousLink->load(std::memory_order_acquire));
+            window.previousLink = nullptr;
+            while (true)
+            {
+                if (current == nullptr) break;
+                uintptr_t next = current->next.load(std::memory_order_acquire);
+
+                // Unlink a removed node; start over if the link has changed
+                if (isMarked(next))
+                {
+                    uintptr_t expected = reinterpret_cast<uintptr_t>(current);
+                    if (!previousLink->compare_exchange_strong(expected, next & ~MARK_BIT, std::memory_order_acq_rel, std::memory_order_acquire)) goto retry;
+                    reclaimer.retire(current, [](void* node) { destroyNode(static_cast<ListNode*>(node)); });
+                    current = pointerOf(next);
+                    continue;
+                }
+
+                if (current->orderKey > orderKey) break;
+                if (current->orderKey == orderKey)
+                {
+                    // New nodes go before the run of nodes with this order key
+                    if (window.previousLink == nullptr)
+                    {
+                        window.previousLink = previousLink;
+                        window.current = current;
+                    }
+                    if (key == nullptr || isMatch(static_cast<EntryNode*>(current), *key, hash))
+                    {
+                        window.foundLink = previousLink;
+                        window.found = current;
+                        return true;
+                    }
+                }
+                previousLink = &current->next;
+                current = pointerOf(next);
+            }
+
+            if (window.previousLink == nullptr)
+            {
+                window.previousLink = previousLink;
+                window.current = current;
+            }
+            window.found = nullptr;
+            return false;
+        }
+
+        bool isMatch(const EntryNode* node, const KEY_TYPE& key, size_t hash) const
+        {
+            return node->hash == hash && keyEqual(node->key, key);
+        }
+
+        // Marks the found node removed, then tries to unlink it. Returns false
+        // if another thread removed the node first.
+        bool markAndUnlink(ListNode* head, Window& window)
+        {
+            ListNode* node = window.found;
+            uintptr_t next = node->next.load(std::memory_order_acquire);
+            do
+            {
+                if (isMarked(next)) return false;
+            } while (!node->next.compare_exchange_weak(next, next | MARK_BIT, std::memory_order_acq_rel, std::memory_order_acquire));
+            elementCount.fetch_sub(1, std::memory_order_relaxed);
+
+            // If the node cannot be unlinked directly, a search unlinks it
+            uintptr_t expected = reinterpret_cast<uintptr_t>(node);
+            if (window.foundLink->compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+                reclaimer.retire(node, [](void* removed) { destroyNode(static_cast<ListNode*>(removed)); });
+            }
+            else
+            {
+                EntryNode* entry = static_cast<EntryNode*>(node);
+                find(head, node->orderKey, &entry->key, entry->hash, window);
+            }
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file StaticHashTable.hpp
+ * @brief Immutable key/value dictionary built entirely at compile time. Uses a
+ * perfect hash found by the compiler, so a table needs no initialization at
+ * startup and no heap memory.
+ *
+ * Example:
+ *
+ *     constexpr auto opcodes = makeStaticHashTable<std::string_view, int>({
+ *         {"GET", 1}, {"PUT", 2}, {"DELETE", 3}
+ *     });
+ *     static_assert(*opcodes.get("PUT") == 2);
+ *
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef STATICHASHTABLE_H
+#define STATICHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include "./HashFunctions.hpp"
+
+// Built the same way as FrozenHashTable: keys are split into groups of about
+// four by the low bits of their hash, and each group is given a displacement
+// that is either a seed sending its keys to distinct free slots or, for a
+// group of one key, the slot itself. The number of slots is a power of two.
+// Slots left over hold a copy of a key whose own slot is elsewhere, so a
+// lookup can never match one and no slot needs an occupied flag.
+//
+// A lookup hashes the key, masks the hash to find its group's displacement,
+// masks the displaced hash to find its slot, and compares one key. Keys and
+// values must be literal types, such as integers, enums and std::string_view,
+// and the hash must be constexpr; DefaultHash is for all of these.
+template<typename KEY_TYPE, typename VALUE_TYPE, size_t N, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class StaticHashTable
+{
+    static_assert(N > 0, "A static hash table must have at least one element");
+
+    private:
+        static constexpr size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t powerOfTwo = 1;
+            while (powerOfTwo < value) powerOfTwo *= 2;
+            return powerOfTwo;
+        }
+
+        // The number of slots and the number of groups
+        static constexpr size_t CAPACITY = roundUpToPowerOfTwo(N);
+        static constexpr size_t GROUP_COUNT = roundUpToPowerOfTwo((N + 3) / 4);
+
+        // A displacement with this bit set holds a slot index rather than a seed
+        static constexpr uint32_t DIRECT_SLOT = (uint32_t)1 << 31;
+
+        // The number of seeds tried for a group before giving up. Far below
+        // DIRECT_SLOT, and low enough that a hopeless search ends with its own
+        // error rather than the compiler's evaluation limit.
+        static constexpr uint32_t MAX_SEED_ATTEMPTS = (uint32_t)1 << 16;
+
+    public:
+        // Constructor. Every key must be distinct; evaluating the constructor
+        // at compile time with a duplicate key is a compile error, and so is a
+        // hash that gives distinct keys the same hash or cannot be spread into
+        // slots, which throws std::overflow_error.
+        constexpr StaticHashTable(const std::pair<KEY_TYPE, VALUE_TYPE> (&elements)[N], const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : keys(), values(), displacements(), hasher(hasher), keyEqual(keyEqual)
+        {
+            size_t hashes[N] = {};
+            size_t groupSizes[GROUP_COUNT] = {};
+            size_t largestGroupSize = 0;
+            for (size_t i = 0; i < N; i++)
+            {
+                hashes[i] = hasher(elements[i].first);
+                size_t groupSize = ++groupSizes[hashes[i] & (GROUP_COUNT - 1)];
+                if (groupSize > largestGroupSize) largestGroupSize = groupSize;
+            }
+
+            // Place the groups of more than one key, largest first
+            bool slotTaken[CAPACITY] = {};
+            size_t slotOfKey[N] = {};
+            for (size_t groupSize = largestGroupSize; groupSize > 1; groupSize--)
+            {
+                for (size_t group = 0; group < GROUP_COUNT; group++)
+                {
+                    if (groupSizes[group] != groupSize) continue;
+                    uint32_t seed = 0;
+                    while (!tryPlaceGroup(elements, hashes, group, seed, slotTaken, slotOfKey))
+                    {
+                        if (++seed == MAX_SEED_ATTEMPTS) throw std::overflow_error("Too many keys in the static hash table share the same hash");
+                    }
+                    displacements[group] = seed;
+                }
+            }
+
+            // Give each group of one key the next free slot
+            size_t nextFreeSlot = 0;
+            for (size_t i = 0; i < N; i++)
+            {
+                size_t group = hashes[i] & (GROUP_COUNT - 1);
+                if (groupSizes[group] != 1) continue;
+                while (slotTaken[nextFreeSlot]) nextFreeSlot++;
+                slotTaken[nextFreeSlot] = true;
+                slotOfKey[i] = nextFreeSlot;
+                displacements[group] = DIRECT_SLOT | (uint32_t)nextFreeSlot;
+            }
+
+            // Fill the slots, and the slots left over with a copy of the first element
+            for (size_t i = 0; i < N; i++)
+            {
+                keys[slotOfKey[i]] = elements[i].first;
+                values[slotOfKey[i]] = elements[i].second;
+            }
+            for (size_t slot = 0; slot < CAPACITY; slot++)
+            {
+                if (slotTaken[slot]) continue;
+                keys[slot] = elements[0].first;
+                values[slot] = elements[0].second;
+            }
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1), with one key comparison
+        constexpr const VALUE_TYPE* get(const KEY_TYPE& key) const
+        {
+            size_t slot = slotOf(hasher(key));
+            if (keyEqual(keys[slot], key)) return &values[slot];
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1), with one key comparison
+        constexpr bool contains(const KEY_TYPE& key) const
+        {
+            return get(key) != nullptr;
+        }
+
+        // Returns the number of elements in the table.
+        constexpr size_t size() const
+        {
+            return N;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        constexpr bool empty() const
+        {
+            return false;
+        }
+
+        // Returns the number of slots in the table
+        constexpr size_t bucketCount() const
+        {
+            return CAPACITY;
+        }
+
+    private:
+        // The key and value of each slot
+        KEY_TYPE keys[CAPACITY];
+        VALUE_TYPE values[CAPACITY];
+
+        // The displacement of each group
+        uint32_t displacements[GROUP_COUNT];
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        static constexpr size_t seededSlot(size_t hash, uint32_t seed)
+        {
+            return mixHashBits(hash + seed * 0x9e3779b97f4a7c15ULL) & (CAPACITY - 1);
+        }
+
+        constexpr size_t slotOf(size_t hash) const
+        {
+            uint32_t displacement = displacements[hash & (GROUP_COUNT - 1)];
+            if (displacement & DIRECT_SLOT) return displacement & ~DIRECT_SLOT;
+            return seededSlot(hash, displacement);
+        }
+
+        // Takes the slots that a seed sends a group's keys to, if they are all
+        // free and distinct
+        constexpr bool tryPlaceGroup(const std::pair<KEY_TYPE, VALUE_TYPE> (&elements)[N], const size_t (&hashes)[N], size_t group, uint32_t seed, bool (&slotTaken)[CAPACITY], size_t (&slotOfKey)[N]) const
+        {
+            size_t placed[N] = {};
+            size_t placedCount = 0;
+            for (size_t i = 0; i < N; i++)
+            {
+                if ((hashes[i] & (GROUP_COUNT - 1)) != group) continue;
+                size_t slot = seededSlot(hashes[i], seed);
+                bool available = !slotTaken[slot];
+                for (size_t j = 0; j < placedCount && available; j++)
+                {
+                    // Distinct keys with the same hash go to the same slot
+                    // whatever the seed, so there is no point searching on
+                    if (hashes[placed[j]] == hashes[i])
+                    {
+                        if (keyEqual(elements[placed[j]].first, elements[i].first)) throw std::invalid_argument("Duplicate key in a static hash table");
+                        throw std::overflow_error("Too many keys in the static hash table share the same hash");
+                    }
+                    available = slotOfKey[placed[j]] != slot;
+                }
+                if (!available) return false;
+                slotOfKey[i] = slot;
+                placed[placedCount++] = i;
+            }
+            for (size_t j = 0; j < placedCount; j++) slotTaken[slotOfKey[placed[j]]] = true;
+            return true;
+        }
+};
+
+// Builds a static hash table from a braced list of key/value pairs, deducing
+// the number of elements
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>, size_t N>
+constexpr StaticHashTable<KEY_TYPE, VALUE_TYPE, N, HASH, KEY_EQUAL> makeStaticHashTable(const std::pair<KEY_TYPE, VALUE_TYPE> (&elements)[N])
+{
+    return StaticHashTable<KEY_TYPE, VALUE_TYPE, N, HASH, KEY_EQUAL>(elements);
+}
+
+#endif
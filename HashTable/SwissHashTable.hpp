@@ -0,0 +1,421 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SwissHashTable.hpp
+ * @brief Open addressing hash table implementation of a key/value dictionary
+ * in the style of Swiss tables. A separate array of control bytes, each
+ * holding 7 bits of its slot's hash, is probed a group of slots at a time with
+ * SIMD byte compares.
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#ifndef SWISSHASHTABLE_H
+#define SWISSHASHTABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "./HashFunctions.hpp"
+
+// Define SWISSHASHTABLE_PORTABLE to probe groups with plain loops instead of
+// SIMD instructions
+#if !defined(SWISSHASHTABLE_PORTABLE) && defined(__AVX2__)
+#define SWISSHASHTABLE_AVX2
+#include <immintrin.h>
+#elif !defined(SWISSHASHTABLE_PORTABLE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SWISSHASHTABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// A control byte is EMPTY, DELETED (a tombstone), or holds the low 7 bits of
+// the hash of the entry in its slot (so full slots are never negative)
+namespace SwissHashTableControl
+{
+    constexpr int8_t EMPTY = -128;
+    constexpr int8_t DELETED = -2;
+}
+
+// A group of consecutive control bytes that is compared all at once. Each
+// match function returns a bit mask with bit i set if control byte i matches.
+struct SwissHashTableGroup
+{
+#if defined(SWISSHASHTABLE_AVX2)
+    static constexpr size_t WIDTH = 32;
+
+    explicit SwissHashTableGroup(const int8_t* controls)
+        : controls(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(controls)))
+    {
+    }
+
+    uint32_t match(int8_t hashBits) const
+    {
+        return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(controls, _mm256_set1_epi8(hashBits)));
+    }
+
+    uint32_t matchEmpty() const
+    {
+        return match(SwissHashTableControl::EMPTY);
+    }
+
+    uint32_t matchEmptyOrDeleted() const
+    {
+        return (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), controls));
+    }
+
+    __m256i controls;
+#elif defined(SWISSHASHTABLE_SSE2)
+    static constexpr size_t WIDTH = 16;
+
+    explicit SwissHashTableGroup(const int8_t* controls)
+        : controls(_mm_loadu_si128(reinterpret_cast<const __m128i*>(controls)))
+    {
+    }
+
+    uint32_t match(int8_t hashBits) const
+    {
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8(hashBits)));
+    }
+
+    uint32_t matchEmpty() const
+    {
+        return match(SwissHashTableControl::EMPTY);
+    }
+
+    uint32_t matchEmptyOrDeleted() const
+    {
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), controls));
+    }
+
+    __m128i controls;
+#else
+    static constexpr size_t WIDTH = 16;
+
+    explicit SwissHashTableGroup(const int8_t* controls)
+    {
+        std::memcpy(this->controls, controls, WIDTH);
+    }
+
+    uint32_t match(int8_t hashBits) const
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < WIDTH; i++) bits |= (uint32_t)(controls[i] == hashBits) << i;
+        return bits;
+    }
+
+    uint32_t matchEmpty() const
+    {
+        return match(SwissHashTableControl::EMPTY);
+    }
+
+    uint32_t matchEmptyOrDeleted() const
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < WIDTH; i++) bits |= (uint32_t)(controls[i] < -1) << i;
+        return bits;
+    }
+
+    int8_t controls[WIDTH];
+#endif
+
+    // Returns the index of the lowest set bit of a non-zero match mask
+    static size_t lowestMatch(uint32_t bits)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return (size_t)__builtin_ctz(bits);
+#else
+        size_t index = 0;
+        while ((bits & 1) == 0)
+        {
+            bits >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+};
+
+template<typename KEY_TYPE, typename VALUE_TYPE>
+struct SwissHashTableSlot
+{
+    KEY_TYPE key;
+    VALUE_TYPE value;
+};
+
+// The top bits of a key's hash choose the group where its probe sequence
+// starts, and the low 7 bits are stored in the control byte of its slot. A
+// lookup compares a whole group of control bytes against those 7 bits at
+// once, and only compares keys for the (usually zero or one) slots that
+// match. A probe ends at the first group with an empty slot, and groups are
+// visited in triangular order so that every group is reached.
+//
+// Pointers returned by get() are invalidated by any insert that grows the table.
+template<typename KEY_TYPE, typename VALUE_TYPE, typename HASH = DefaultHash<KEY_TYPE>, typename KEY_EQUAL = std::equal_to<KEY_TYPE>>
+class SwissHashTable
+{
+    public:
+        // Constructor. The capacity is rounded up to a power of two of at
+        // least one group, and the table grows once it is 7/8 full.
+        SwissHashTable(size_t tableSize = 16, const HASH& hasher = HASH(), const KEY_EQUAL& keyEqual = KEY_EQUAL())
+            : hasher(hasher), keyEqual(keyEqual)
+        {
+            allocateSlots(roundUpToPowerOfTwo(tableSize));
+        }
+
+        SwissHashTable(const SwissHashTable&) = delete;
+        SwissHashTable& operator=(const SwissHashTable&) = delete;
+
+        // Destructor
+        ~SwissHashTable()
+        {
+            clear();
+            deallocateSlots();
+        }
+
+        // Inserts a key/value pair into the table. If the key already exists, the value will be overwritten.
+        // Algorithmic runtime: O(1) expected
+        void insert(const KEY_TYPE& key, const VALUE_TYPE& value)
+        {
+            size_t hash = hasher(key);
+            size_t index;
+            if (findIndex(key, hash, index))
+            {
+                slots[index].value = value;
+                return;
+            }
+
+            // The key does not exist; make room if there is none left
+            if (growthLeft == 0) makeRoom();
+            index = findFreeIndex(hash);
+            if (controls[index] == SwissHashTableControl::EMPTY) growthLeft--;
+            new (&slots[index]) SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>{key, value};
+            controls[index] = hashBits(hash);
+            numberOfElements++;
+        }
+
+        // Removes a key/value pair from the table if it exists, returns false if it does not exist
+        // Algorithmic runtime: O(1) expected
+        bool remove(const KEY_TYPE& key)
+        {
+            size_t index;
+            if (!findIndex(key, hasher(key), index)) return false;
+            slots[index].~SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            numberOfElements--;
+
+            // A probe that reaches this group stops here if the group still
+            // has an empty slot, so the slot can become empty again; otherwise
+            // a tombstone keeps later probes going
+            size_t groupStart = index & ~(SwissHashTableGroup::WIDTH - 1);
+            if (SwissHashTableGroup(controls + groupStart).matchEmpty())
+            {
+                controls[index] = SwissHashTableControl::EMPTY;
+                growthLeft++;
+            }
+            else controls[index] = SwissHashTableControl::DELETED;
+            return true;
+        }
+
+        // Returns a pointer to the value associated with the key, or null if the key does not exist
+        // Algorithmic runtime: O(1) expected
+        VALUE_TYPE* get(const KEY_TYPE& key)
+        {
+            size_t index;
+            if (findIndex(key, hasher(key), index)) return &slots[index].value;
+            return nullptr;
+        }
+
+        // Returns true if the key exists in the table, false if it does not
+        // Algorithmic runtime: O(1) expected
+        bool contains(const KEY_TYPE& key)
+        {
+            size_t index;
+            return findIndex(key, hasher(key), index);
+        }
+
+        // Clears all elements from the table. Does not shrink the slot array.
+        // Algorithmic runtime: O(capacity)
+        void clear()
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (controls[i] >= 0) slots[i].~SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+                controls[i] = SwissHashTableControl::EMPTY;
+            }
+            numberOfElements = 0;
+            growthLeft = maxElements(capacity);
+        }
+
+        // Returns the number of elements in the table.
+        size_t size() const
+        {
+            return numberOfElements;
+        }
+
+        // Returns true if the table is empty, false if it is not
+        bool empty() const
+        {
+            return numberOfElements == 0;
+        }
+
+        // Prints the contents of the table to an output stream (the console by default)
+        void print(std::ostream& outputStream = std::cout)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                if (controls[i] < 0) continue;
+                outputStream << slots[i].key << ": " << slots[i].value << std::endl;
+            }
+        }
+
+        // Returns the number of slots in the table
+        size_t bucketCount() const
+        {
+            return capacity;
+        }
+
+        // Returns the fraction of slots that are occupied
+        float loadFactor() const
+        {
+            return (float)numberOfElements / capacity;
+        }
+
+        // Grows the table so that it can hold at least the given number of
+        // elements without growing again
+        void reserve(size_t elementCount)
+        {
+            size_t requiredCapacity = capacity;
+            while (maxElements(requiredCapacity) < elementCount) requiredCapacity *= 2;
+            if (requiredCapacity > capacity) rehash(requiredCapacity);
+        }
+
+    private:
+        // The control byte array, the slot array and its allocator
+        int8_t* controls;
+        SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>* slots;
+        std::allocator<SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>> slotAllocator;
+
+        // The hash and key equality functors
+        HASH hasher;
+        KEY_EQUAL keyEqual;
+
+        // The number of slots (a power of two) and the mask that reduces a
+        // hash to a group number
+        size_t capacity;
+        size_t groupMask;
+
+        // The number of elements in the table, and the number of empty slots
+        // that may still be filled before the table must grow
+        size_t numberOfElements = 0;
+        size_t growthLeft;
+
+        static size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t powerOfTwo = SwissHashTableGroup::WIDTH;
+            while (powerOfTwo < value) powerOfTwo *= 2;
+            return powerOfTwo;
+        }
+
+        // The table is kept at most 7/8 full so that every probe sequence
+        // reaches an empty slot quickly
+        static size_t maxElements(size_t capacity)
+        {
+            return capacity - capacity / 8;
+        }
+
+        static int8_t hashBits(size_t hash)
+        {
+            return (int8_t)(hash & 0x7F);
+        }
+
+        size_t firstGroup(size_t hash) const
+        {
+            return (hash >> 7) & groupMask;
+        }
+
+        void allocateSlots(size_t newCapacity)
+        {
+            slots = slotAllocator.allocate(newCapacity);
+            controls = new int8_t[newCapacity];
+            std::memset(controls, (unsigned char)SwissHashTableControl::EMPTY, newCapacity);
+            capacity = newCapacity;
+            groupMask = newCapacity / SwissHashTableGroup::WIDTH - 1;
+            growthLeft = maxElements(newCapacity) - numberOfElements;
+        }
+
+        void deallocateSlots()
+        {
+            slotAllocator.deallocate(slots, capacity);
+            delete[] controls;
+        }
+
+        // Finds the slot holding the key, returning false if there is none
+        bool findIndex(const KEY_TYPE& key, size_t hash, size_t& index) const
+        {
+            int8_t bits = hashBits(hash);
+            size_t group = firstGroup(hash);
+            for (size_t step = 1; ; step++)
+            {
+                size_t groupStart = group * SwissHashTableGroup::WIDTH;
+                SwissHashTableGroup controlGroup(controls + groupStart);
+                for (uint32_t matches = controlGroup.match(bits); matches != 0; matches &= matches - 1)
+                {
+                    index = groupStart + SwissHashTableGroup::lowestMatch(matches);
+                    if (keyEqual(slots[index].key, key)) return true;
+                }
+                if (controlGroup.matchEmpty()) return false;
+                group = (group + step) & groupMask;
+            }
+        }
+
+        // Returns the first empty or deleted slot in the probe sequence of the hash
+        size_t findFreeIndex(size_t hash) const
+        {
+            size_t group = firstGroup(hash);
+            for (size_t step = 1; ; step++)
+            {
+                size_t groupStart = group * SwissHashTableGroup::WIDTH;
+                uint32_t free = SwissHashTableGroup(controls + groupStart).matchEmptyOrDeleted();
+                if (free != 0) return groupStart + SwissHashTableGroup::lowestMatch(free);
+                group = (group + step) & groupMask;
+            }
+        }
+
+        // Called when no empty slots may be filled. If the table is no more
+        // than 25/32 full, tombstones are taking the room and rehashing in
+        // place reclaims them; otherwise grow.
+        void makeRoom()
+        {
+            if (capacity > SwissHashTableGroup::WIDTH && numberOfElements * 32 <= capacity * 25) rehash(capacity);
+            else rehash(capacity * 2);
+        }
+
+        // Moves every entry into new slot and control arrays of the given capacity
+        void rehash(size_t newCapacity)
+        {
+            int8_t* oldControls = controls;
+            SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>* oldSlots = slots;
+            size_t oldCapacity = capacity;
+            allocateSlots(newCapacity);
+
+            for (size_t i = 0; i < oldCapacity; i++)
+            {
+                if (oldControls[i] < 0) continue;
+                size_t hash = hasher(oldSlots[i].key);
+                size_t index = findFreeIndex(hash);
+                new (&slots[index]) SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>(std::move(oldSlots[i]));
+                controls[index] = hashBits(hash);
+                oldSlots[i].~SwissHashTableSlot<KEY_TYPE, VALUE_TYPE>();
+            }
+
+            slotAllocator.deallocate(oldSlots, oldCapacity);
+            delete[] oldControls;
+        }
+};
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file CommonHashTableTests.cpp
+ * @brief Unit tests for the dictionary API shared by the alternative hash table implementations
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../CompactHashTable.hpp"
+#include "../ConcurrentHashTable.hpp"
+#include "../CuckooHashTable.hpp"
+#include "../RcuHashTable.hpp"
+#include "../RobinHoodHashTable.hpp"
+#include "../SplitOrderedHashTable.hpp"
+#include "../SwissHashTable.hpp"
+#include <optional>
+#include <string>
+
+// Tables whose get() returns a pointer into the table
+TEMPLATE_TEST_CASE("Single-threaded tables insert, get, remove and clear like a dictionary", "[insert()][get()][remove()][clear()]",
+    (RobinHoodHashTable<int, std::string>), (SwissHashTable<int, std::string>), (CuckooHashTable<int, std::string>), (CompactHashTable<int, std::string>))
+{
+    TestType testTable;
+    testTable.insert(10, "ten");
+    testTable.insert(5, "five");
+    testTable.insert(15, "fifteen");
+
+    SECTION("Inserted values can be retrieved")
+    {
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(testTable.empty() == false);
+        REQUIRE(*testTable.get(10) == "ten");
+        REQUIRE(*testTable.get(5) == "five");
+        REQUIRE(*testTable.get(15) == "fifteen");
+        REQUIRE(testTable.contains(15) == true);
+    }
+
+    SECTION("Keys that were never inserted are not found")
+    {
+        REQUIRE(testTable.get(20) == nullptr);
+        REQUIRE(testTable.contains(20) == false);
+    }
+
+    SECTION("Inserting an existing key overwrites its value")
+    {
+        testTable.insert(5, "FIVE");
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(*testTable.get(5) == "FIVE");
+    }
+
+    SECTION("Removing a key removes only that key")
+    {
+        REQUIRE(testTable.remove(10) == true);
+        REQUIRE(testTable.remove(10) == false);
+        REQUIRE(testTable.size() == 2);
+        REQUIRE(testTable.contains(10) == false);
+        REQUIRE(*testTable.get(5) == "five");
+    }
+
+    SECTION("Clearing the table removes every element, and it can be refilled")
+    {
+        testTable.clear();
+        REQUIRE(testTable.empty() == true);
+        REQUIRE(testTable.get(5) == nullptr);
+        testTable.insert(5, "five again");
+        REQUIRE(*testTable.get(5) == "five again");
+    }
+}
+
+// Tables safe for concurrent use, whose get() returns a copy of the value
+TEMPLATE_TEST_CASE("Concurrent tables insert, get, remove and clear like a dictionary on one thread", "[insert()][get()][remove()][clear()]",
+    (ConcurrentHashTable<int, std::string>), (SplitOrderedHashTable<int, std::string>), (RcuHashTable<int, std::string>))
+{
+    TestType testTable;
+    testTable.insert(10, "ten");
+    testTable.insert(5, "five");
+    testTable.insert(15, "fifteen");
+
+    SECTION("Inserted values can be retrieved")
+    {
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(*testTable.get(10) == "ten");
+        REQUIRE(*testTable.get(5) == "five");
+        REQUIRE(testTable.contains(15) == true);
+        REQUIRE(testTable.get(20) == std::nullopt);
+    }
+
+    SECTION("Inserting an existing key overwrites its value")
+    {
+        testTable.insert(10, "TEN");
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(*testTable.get(10) == "TEN");
+    }
+
+    SECTION("Removing a key removes only that key")
+    {
+        REQUIRE(testTable.remove(10) == true);
+        REQUIRE(testTable.remove(10) == false);
+        REQUIRE(testTable.size() == 2);
+        REQUIRE(testTable.contains(10) == false);
+        REQUIRE(testTable.contains(5) == true);
+    }
+
+    SECTION("Clearing the table removes every element, and it can be refilled")
+    {
+        testTable.clear();
+        REQUIRE(testTable.empty() == true);
+        REQUIRE(testTable.get(5) == std::nullopt);
+        testTable.insert(5, "five again");
+        REQUIRE(*testTable.get(5) == "five again");
+    }
+}
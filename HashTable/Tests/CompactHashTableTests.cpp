@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file CompactHashTableTests.cpp
+ * @brief Unit tests for an insertion-ordered, compact hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../CompactHashTable.hpp"
+#include <sstream>
+#include <vector>
+
+TEST_CASE("Compact table iterates in insertion order", "[CompactHashTable][forEach()]")
+{
+    CompactHashTable<std::string, int> testTable;
+    for (int i = 0; i < 1000; i++) testTable.insert("key" + std::to_string((i * 7919) % 1000), i);
+
+    SECTION("Elements are visited in the order their keys were first inserted")
+    {
+        std::vector<int> values;
+        testTable.forEach([&](const std::string&, int value) { values.push_back(value); });
+        bool inOrder = values.size() == 1000;
+        for (size_t i = 0; i < values.size() && inOrder; i++) inOrder = values[i] == (int)i;
+        REQUIRE(inOrder);
+    }
+
+    SECTION("Overwriting a value keeps its place, and removed elements are skipped")
+    {
+        testTable.insert("key0", -1);
+        for (int i = 1; i < 1000; i += 2) testTable.remove("key" + std::to_string((i * 7919) % 1000));
+        std::vector<int> values;
+        testTable.forEach([&](const std::string&, int value) { values.push_back(value); });
+        REQUIRE(values.size() == 500);
+        REQUIRE(values[0] == -1);
+        REQUIRE(values[1] == 2);
+        REQUIRE(values[499] == 998);
+    }
+
+    SECTION("Printing lists elements in insertion order")
+    {
+        CompactHashTable<int, int> smallTable;
+        smallTable.insert(3, 30);
+        smallTable.insert(1, 10);
+        smallTable.insert(2, 20);
+        std::stringstream outputStream;
+        smallTable.print(outputStream);
+        REQUIRE(outputStream.str() == "3: 30\n1: 10\n2: 20\n");
+    }
+}
+
+TEST_CASE("Compact table index slots widen as the table grows", "[CompactHashTable]")
+{
+    CompactHashTable<int, int> testTable;
+    REQUIRE(testTable.indexBytes() == testTable.bucketCount());
+
+    for (int i = 0; i < 100000; i++) testTable.insert(i, i * 2);
+    bool allFound = true;
+    for (int i = 0; i < 100000; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i * 2;
+    REQUIRE(allFound);
+    REQUIRE(testTable.size() == 100000);
+    REQUIRE(testTable.indexBytes() == testTable.bucketCount() * 4);
+}
+
+TEST_CASE("Compact remove behaves as expected", "[CompactHashTable][remove()]")
+{
+    CompactHashTable<int, int> testTable;
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i);
+
+    SECTION("Removing keys leaves every other key reachable")
+    {
+        for (int i = 0; i < 1000; i += 2) REQUIRE(testTable.remove(i) == true);
+
+        bool remainingFound = true;
+        bool removedMissing = true;
+        for (int i = 0; i < 1000; i++)
+        {
+            if (i % 2 == 0) removedMissing = removedMissing && !testTable.contains(i);
+            else remainingFound = remainingFound && *testTable.get(i) == i;
+        }
+        REQUIRE(testTable.size() == 500);
+        REQUIRE(remainingFound);
+        REQUIRE(removedMissing);
+    }
+
+    SECTION("Removing a key that does not exist returns false")
+    {
+        REQUIRE(testTable.remove(5000) == false);
+        REQUIRE(testTable.size() == 1000);
+    }
+
+    SECTION("Repeatedly removing and inserting reuses the arrays")
+    {
+        size_t slots = testTable.bucketCount();
+        for (int round = 0; round < 20; round++)
+        {
+            for (int i = 0; i < 1000; i++) testTable.remove(i);
+            for (int i = 0; i < 1000; i++) testTable.insert(i, i + round);
+        }
+        REQUIRE(testTable.size() == 1000);
+        REQUIRE(*testTable.get(999) == 1018);
+        REQUIRE(testTable.bucketCount() <= slots * 2);
+    }
+}
+
+TEST_CASE("Compact clear behaves as expected", "[CompactHashTable][clear()]")
+{
+    CompactHashTable<std::string, std::string> testTable;
+    for (int i = 0; i < 100; i++) testTable.insert(std::to_string(i), std::to_string(i * i));
+    testTable.clear();
+
+    REQUIRE(testTable.size() == 0);
+    REQUIRE(testTable.contains("5") == false);
+    testTable.insert("5", "25");
+    REQUIRE(*testTable.get("5") == "25");
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file ConcurrentHashTableTests.cpp
+ * @brief Unit tests for a thread-safe, lock-striped hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../ConcurrentHashTable.hpp"
+#include <thread>
+#include <vector>
+
+TEST_CASE("Concurrent hash table update modifies the value in place", "[ConcurrentHashTable][update()]")
+{
+    ConcurrentHashTable<int, std::string> testTable;
+    testTable.insert(5, "five");
+
+    REQUIRE(testTable.update(5, [](std::string& value) { value += "!"; }) == true);
+    REQUIRE(testTable.update(20, [](std::string& value) { value += "!"; }) == false);
+    REQUIRE(*testTable.get(5) == "five!");
+    REQUIRE(testTable.contains(20) == false);
+}
+
+TEST_CASE("Concurrent hash table handles many threads at once", "[ConcurrentHashTable]")
+{
+    ConcurrentHashTable<int, int> testTable(16, 8);
+    const int threadCount = 8;
+    const int keysPerThread = 5000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&testTable, t]()
+        {
+            for (int i = 0; i < keysPerThread; i++)
+            {
+                int key = t * keysPerThread + i;
+                testTable.insert(key, key);
+                testTable.get(key / 2);
+                testTable.update(key % 100, [](int& value) { value++; });
+                if (i % 3 == 0) testTable.remove(key);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool allCorrect = true;
+    for (int key = 100; key < threadCount * keysPerThread; key++)
+    {
+        bool removed = (key % keysPerThread) % 3 == 0;
+        allCorrect = allCorrect && (removed ? !testTable.contains(key) : *testTable.get(key) == key);
+    }
+
+    REQUIRE(allCorrect);
+    REQUIRE(testTable.bucketCount() >= testTable.size());
+}
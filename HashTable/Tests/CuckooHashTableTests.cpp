@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file CuckooHashTableTests.cpp
+ * @brief Unit tests for a bucketized cuckoo hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../CuckooHashTable.hpp"
+#include <vector>
+
+TEST_CASE("Cuckoo table holds a high load factor", "[CuckooHashTable][insert()]")
+{
+    CuckooHashTable<int, int> testTable(16, 0.95f);
+    for (int i = 0; i < 20000; i++) testTable.insert(i * 7, i);
+
+    bool allFound = true;
+    for (int i = 0; i < 20000; i++) allFound = allFound && testTable.get(i * 7) != nullptr && *testTable.get(i * 7) == i;
+
+    REQUIRE(testTable.size() == 20000);
+    REQUIRE(allFound);
+    REQUIRE(testTable.loadFactor() <= 0.95f);
+    REQUIRE(testTable.loadFactor() > 0.45f);
+}
+
+TEST_CASE("Cuckoo table fills its buckets before growing", "[CuckooHashTable]")
+{
+    CuckooHashTable<int, int> testTable(64);
+    REQUIRE(testTable.bucketCount() == 16);
+    for (int i = 0; i < 60; i++) testTable.insert(i, i);
+    REQUIRE(testTable.bucketCount() == 16);
+}
+
+struct CuckooHashTableTestConstantHash
+{
+    size_t operator()(int) const
+    {
+        return 42;
+    }
+};
+
+TEST_CASE("Cuckoo insert throws once more keys share a hash than two buckets hold", "[CuckooHashTable][insert()]")
+{
+    // Keys that share a hash share both of their buckets, which hold eight
+    // between them however large the table grows
+    CuckooHashTable<int, int, CuckooHashTableTestConstantHash> testTable;
+    for (int i = 0; i < 8; i++) testTable.insert(i, i);
+    REQUIRE(testTable.size() == 8);
+
+    SECTION("A ninth key throws and leaves the other keys in place")
+    {
+        REQUIRE_THROWS_AS(testTable.insert(8, 8), std::overflow_error);
+
+        bool allFound = true;
+        for (int i = 0; i < 8; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+        REQUIRE(testTable.size() == 8);
+        REQUIRE(allFound);
+        REQUIRE(testTable.contains(8) == false);
+    }
+
+    SECTION("Removing one of the keys frees a slot for the ninth")
+    {
+        REQUIRE(testTable.remove(3) == true);
+        testTable.insert(8, 8);
+        REQUIRE(*testTable.get(8) == 8);
+        REQUIRE(testTable.size() == 8);
+        REQUIRE_THROWS_AS(testTable.insert(3, 3), std::overflow_error);
+    }
+}
+
+// Uses the key as its own hash, so that a test can choose each key's first
+// bucket (the low bits) and tag (the top byte)
+struct CuckooHashTableTestIdentityHash
+{
+    size_t operator()(size_t key) const
+    {
+        return key;
+    }
+};
+
+TEST_CASE("Cuckoo insert moves entries along a path to a free slot", "[CuckooHashTable][insert()]")
+{
+    // Four buckets. With that mask, tag 1 pairs buckets 0/1 and 2/3, and tag 2
+    // pairs buckets 0/2 and 1/3.
+    CuckooHashTable<size_t, size_t, CuckooHashTableTestIdentityHash> testTable(16);
+    REQUIRE(testTable.bucketCount() == 4);
+    auto makeKey = [](size_t tag, size_t bucket, size_t index) { return (tag << (sizeof(size_t) * 8 - 8)) | (index << 2) | bucket; };
+
+    // Fill bucket 0 with keys that may move to bucket 2, bucket 1 with keys
+    // that may only move back to bucket 0, and bucket 2 with keys that may
+    // move to bucket 3
+    std::vector<size_t> keys;
+    for (size_t i = 0; i < 4; i++) keys.push_back(makeKey(2, 0, i));
+    for (size_t i = 0; i < 4; i++) keys.push_back(makeKey(1, 1, i));
+    for (size_t i = 0; i < 4; i++) keys.push_back(makeKey(1, 2, i));
+    for (size_t key : keys) testTable.insert(key, key);
+
+    // Both buckets of the new key are full, and so is every bucket one move
+    // away, so an entry of bucket 2 moves to bucket 3 and an entry of bucket
+    // 0 takes its place before the key fits
+    keys.push_back(makeKey(1, 0, 4));
+    testTable.insert(keys.back(), keys.back());
+
+    bool allFound = true;
+    for (size_t key : keys) allFound = allFound && testTable.get(key) != nullptr && *testTable.get(key) == key;
+    REQUIRE(testTable.size() == 13);
+    REQUIRE(testTable.bucketCount() == 4);
+    REQUIRE(allFound);
+}
+
+TEST_CASE("Cuckoo remove behaves as expected", "[CuckooHashTable][remove()]")
+{
+    CuckooHashTable<int, int> testTable;
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i);
+
+    SECTION("Removing keys leaves every other key reachable")
+    {
+        for (int i = 0; i < 1000; i += 2) REQUIRE(testTable.remove(i) == true);
+
+        bool remainingFound = true;
+        bool removedMissing = true;
+        for (int i = 0; i < 1000; i++)
+        {
+            if (i % 2 == 0) removedMissing = removedMissing && !testTable.contains(i);
+            else remainingFound = remainingFound && *testTable.get(i) == i;
+        }
+        REQUIRE(testTable.size() == 500);
+        REQUIRE(remainingFound);
+        REQUIRE(removedMissing);
+    }
+
+    SECTION("Removing a key that does not exist returns false")
+    {
+        REQUIRE(testTable.remove(5000) == false);
+        REQUIRE(testTable.size() == 1000);
+    }
+}
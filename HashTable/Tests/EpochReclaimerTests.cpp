@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file EpochReclaimerTests.cpp
+ * @brief Unit tests for epoch-based memory reclamation
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../EpochReclaimer.hpp"
+#include <atomic>
+#include <thread>
+
+namespace EpochReclaimerTests
+{
+    std::atomic<int> freedObjects{0};
+
+    void countFree(void* object)
+    {
+        delete static_cast<int*>(object);
+        freedObjects++;
+    }
+}
+
+TEST_CASE("Retired objects are freed only once no thread is pinned before them", "[EpochReclaimer][retire()]")
+{
+    EpochReclaimer& reclaimer = EpochReclaimer::instance();
+    EpochReclaimerTests::freedObjects = 0;
+
+    SECTION("An unpinned thread's retired objects are freed by synchronize()")
+    {
+        reclaimer.retire(new int(1), EpochReclaimerTests::countFree);
+        reclaimer.synchronize();
+        REQUIRE(EpochReclaimerTests::freedObjects == 1);
+    }
+
+    SECTION("A pinned reader holds back objects retired after it pinned")
+    {
+        std::atomic<bool> pinned{false};
+        std::atomic<bool> release{false};
+        std::thread reader([&]()
+        {
+            EpochReclaimer::Guard guard(reclaimer);
+            pinned = true;
+            while (!release) std::this_thread::yield();
+        });
+        while (!pinned) std::this_thread::yield();
+
+        reclaimer.retire(new int(2), EpochReclaimerTests::countFree);
+        for (int i = 0; i < 10; i++) reclaimer.collect();
+        REQUIRE(EpochReclaimerTests::freedObjects == 0);
+
+        release = true;
+        reader.join();
+        reclaimer.synchronize();
+        REQUIRE(EpochReclaimerTests::freedObjects == 1);
+    }
+
+    SECTION("Guards may be nested")
+    {
+        {
+            EpochReclaimer::Guard outer(reclaimer);
+            EpochReclaimer::Guard inner(reclaimer);
+        }
+        reclaimer.retire(new int(3), EpochReclaimerTests::countFree);
+        reclaimer.synchronize();
+        REQUIRE(EpochReclaimerTests::freedObjects == 1);
+    }
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file FrozenHashTableTests.cpp
+ * @brief Unit tests for an immutable, minimal perfect hash table built from a hash table
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../FrozenHashTable.hpp"
+
+TEST_CASE("Frozen hash table holds every element of its source", "[FrozenHashTable]")
+{
+    HashTable<std::string, int> source;
+    for (int i = 0; i < 1000; i++) source.insert("key" + std::to_string(i), i);
+    FrozenHashTable<std::string, int> testTable(source);
+
+    SECTION("Every key is found with its value")
+    {
+        bool allFound = true;
+        for (int i = 0; i < 1000; i++) allFound = allFound && testTable.get("key" + std::to_string(i)) != nullptr && *testTable.get("key" + std::to_string(i)) == i;
+        REQUIRE(allFound);
+        REQUIRE(testTable.size() == 1000);
+        REQUIRE(testTable.empty() == false);
+    }
+
+    SECTION("Keys that were never inserted are not found")
+    {
+        bool noneFound = true;
+        for (int i = 1000; i < 2000; i++) noneFound = noneFound && !testTable.contains("key" + std::to_string(i));
+        REQUIRE(noneFound);
+    }
+
+    SECTION("The frozen table does not change with its source")
+    {
+        source.insert("key0", -1);
+        source.remove("key1");
+        REQUIRE(*testTable.get("key0") == 0);
+        REQUIRE(*testTable.get("key1") == 1);
+    }
+
+    SECTION("The displacement array takes about one byte per key")
+    {
+        REQUIRE(testTable.displacementBytes() == 250 * sizeof(uint32_t));
+    }
+
+    SECTION("Frozen tables can be moved")
+    {
+        FrozenHashTable<std::string, int> movedTable(std::move(testTable));
+        REQUIRE(*movedTable.get("key999") == 999);
+        REQUIRE(testTable.empty() == true);
+        REQUIRE(testTable.get("key999") == nullptr);
+    }
+}
+
+TEST_CASE("Frozen hash table handles small and large sources", "[FrozenHashTable]")
+{
+    SECTION("An empty source gives an empty table")
+    {
+        HashTable<int, int> source;
+        FrozenHashTable<int, int> testTable(source);
+        REQUIRE(testTable.empty() == true);
+        REQUIRE(testTable.get(1) == nullptr);
+    }
+
+    SECTION("A source with one element")
+    {
+        HashTable<int, int> source;
+        source.insert(7, 49);
+        FrozenHashTable<int, int> testTable(source);
+        REQUIRE(*testTable.get(7) == 49);
+        REQUIRE(testTable.get(8) == nullptr);
+    }
+
+    SECTION("A large source mid-way through an incremental rehash")
+    {
+        HashTable<int, int> source(16);
+        source.setIncrementalRehash(true);
+        for (int i = 0; i < 100000; i++) source.insert(i * 3, i);
+        FrozenHashTable<int, int> testTable(source);
+
+        bool allFound = true;
+        for (int i = 0; i < 100000; i++) allFound = allFound && testTable.get(i * 3) != nullptr && *testTable.get(i * 3) == i;
+        REQUIRE(allFound);
+        REQUIRE(testTable.contains(1) == false);
+    }
+}
+
+TEST_CASE("Frozen hash table spreads keys from a hasher with weak high bits", "[FrozenHashTable]")
+{
+    // std::hash<int> returns the key itself, so every high bit is zero
+    HashTable<int, int, std::hash<int>> source;
+    for (int i = 0; i < 2000; i++) source.insert(i, i * 2);
+    FrozenHashTable<int, int, std::hash<int>> testTable(source);
+
+    bool allFound = true;
+    for (int i = 0; i < 2000; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i * 2;
+    REQUIRE(testTable.size() == 2000);
+    REQUIRE(allFound);
+    REQUIRE(testTable.contains(2000) == false);
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file HashFunctionsTests.cpp
+ * @brief Unit tests for the default hash functions used by the hash table collections
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../HashFunctions.hpp"
+#include "../HashTable.hpp"
+#include <cstring>
+#include <limits>
+
+struct HashFunctionsTestPoint
+{
+    int x;
+    int y;
+};
+
+struct HashFunctionsTestStreamable
+{
+    double weight;
+    char tag;
+};
+
+std::ostream& operator<<(std::ostream& outputStream, const HashFunctionsTestStreamable& value)
+{
+    return outputStream << value.weight << value.tag;
+}
+
+TEST_CASE("Integral keys are hashed by mixing their bits", "[HashFunctions][DefaultHash]")
+{
+    DefaultHash<int> hash;
+
+    SECTION("Equal keys produce equal hashes")
+    {
+        REQUIRE(hash(42) == hash(42));
+    }
+
+    SECTION("Consecutive keys are spread across the low bits")
+    {
+        REQUIRE((hash(1) & 0xff) != (hash(2) & 0xff));
+        REQUIRE(hash(0) != hash(1));
+    }
+}
+
+TEST_CASE("String keys are hashed over their characters in place", "[HashFunctions][DefaultHash]")
+{
+    std::string key = "structbucket";
+
+    SECTION("Every string type hashes the same characters to the same value")
+    {
+        REQUIRE(DefaultHash<std::string>()(key) == DefaultHash<const char*>()("structbucket"));
+        REQUIRE(DefaultHash<std::string>()(key) == DefaultHash<std::string_view>()(std::string_view(key)));
+    }
+
+    SECTION("Different strings produce different hashes")
+    {
+        REQUIRE(DefaultHash<std::string>()(key) != DefaultHash<std::string>()("structbucker"));
+    }
+
+    SECTION("String views can be hashed at compile time")
+    {
+        constexpr size_t compileTimeHash = DefaultHash<std::string_view>()("structbucket");
+        REQUIRE(compileTimeHash == DefaultHash<std::string>()(key));
+    }
+}
+
+TEST_CASE("Plain-old-data and fallback keys are hashed consistently", "[HashFunctions][DefaultHash]")
+{
+    SECTION("Plain-old-data keys are hashed by their bytes")
+    {
+        DefaultHash<HashFunctionsTestPoint> hash;
+        REQUIRE(hash({1, 2}) == hash({1, 2}));
+        REQUIRE(hash({1, 2}) != hash({2, 1}));
+    }
+
+    SECTION("Positive and negative zero hash to the same value")
+    {
+        REQUIRE(DefaultHash<double>()(0.0) == DefaultHash<double>()(-0.0));
+    }
+
+    SECTION("Equal long doubles hash to the same value whatever their padding bytes hold")
+    {
+        long double value = 1.5L;
+        unsigned char zeroPadded[sizeof(long double)];
+        unsigned char onePadded[sizeof(long double)];
+        std::memset(zeroPadded, 0x00, sizeof(long double));
+        std::memset(onePadded, 0xff, sizeof(long double));
+        size_t valueBytes = std::numeric_limits<long double>::digits == 64 && sizeof(long double) > 10 ? 10 : sizeof(long double);
+        std::memcpy(zeroPadded, &value, valueBytes);
+        std::memcpy(onePadded, &value, valueBytes);
+
+        long double first;
+        long double second;
+        std::memcpy(&first, zeroPadded, sizeof(long double));
+        std::memcpy(&second, onePadded, sizeof(long double));
+        REQUIRE(first == second);
+        REQUIRE(DefaultHash<long double>()(first) == DefaultHash<long double>()(second));
+    }
+
+    SECTION("Keys with padding fall back to hashing their stream representation")
+    {
+        DefaultHash<HashFunctionsTestStreamable> hash;
+        REQUIRE(hash({1.5, 'a'}) == jenkinsStreamHash(HashFunctionsTestStreamable{1.5, 'a'}));
+    }
+}
+
+TEST_CASE("Hash table uses the default hash functions for string keys", "[HashFunctions][HashTable]")
+{
+    HashTable<std::string, int> testTable;
+    testTable.insert("one", 1);
+    testTable.insert("two", 2);
+
+    REQUIRE(*testTable.get("one") == 1);
+    REQUIRE(*testTable.get("two") == 2);
+    REQUIRE(testTable.get("three") == nullptr);
+}
@@ -10,6 +10,12 @@
 
 #include "../../Libraries/Catch2/catch.hpp"
 #include "../HashTable.hpp"
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
 
 TEST_CASE("Insert method behaves as expected when there is no collision", "[HashTable][insert()]")
 {
@@ -43,7 +49,8 @@ TEST_CASE("Insert method behaves as expected when there is no collision", "[Hash
 
 TEST_CASE("Insert method behaves as expected when there are collisions", "[HashTable][insert()]")
 {
-    HashTable<int, std::string> testTable(1);
+    // Disable automatic rehashing so that every key shares the single bucket
+    HashTable<int, std::string> testTable(1, nullptr, std::numeric_limits<float>::infinity());
     testTable.insert(10, "ten");
     testTable.insert(5, "five");
 
@@ -149,7 +156,8 @@ TEST_CASE("Clear function behaves as expected when there are no collisions")
 
 TEST_CASE("Clear function behaves as expected when there are collisions")
 {
-    HashTable<int, std::string> testTable(1);
+    // Disable automatic rehashing so that every key shares the single bucket
+    HashTable<int, std::string> testTable(1, nullptr, std::numeric_limits<float>::infinity());
     testTable.insert(10, "ten");
     testTable.insert(5, "five");
     testTable.clear();
@@ -168,7 +176,8 @@ TEST_CASE("Clear function behaves as expected when there are collisions")
 
 TEST_CASE("Size function behaves as expected when there are collisions")
 {
-    HashTable<int, std::string> testTable(1);
+    // Disable automatic rehashing so that every key shares the single bucket
+    HashTable<int, std::string> testTable(1, nullptr, std::numeric_limits<float>::infinity());
     testTable.insert(10, "ten");
     testTable.insert(5, "five");
 
@@ -212,6 +221,946 @@ TEST_CASE("Print function behaves as expected")
     {
         std::stringstream outputStream;
         testTable.print(outputStream);
-        REQUIRE(outputStream.str() == "5: five\n10: ten\n15: fifteen\n");
+        REQUIRE(outputStream.str() == "10: ten\n5: five\n15: fifteen\n");
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Table array grows automatically to respect the maximum load factor", "[HashTable][rehash()]")
+{
+    HashTable<int, int> testTable(4);
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i * 2);
+
+    SECTION("The load factor never exceeds the maximum load factor")
+    {
+        REQUIRE(testTable.bucketCount() >= 1000);
+        REQUIRE(testTable.loadFactor() <= testTable.getMaxLoadFactor());
+    }
+
+    SECTION("Every element can still be retrieved after the table array grows")
+    {
+        REQUIRE(testTable.size() == 1000);
+        for (int i = 0; i < 1000; i++) REQUIRE(*testTable.get(i) == i * 2);
+    }
+
+    SECTION("Lowering the maximum load factor rehashes the table immediately")
+    {
+        testTable.setMaxLoadFactor(0.5f);
+        REQUIRE(testTable.loadFactor() <= 0.5f);
+        REQUIRE(*testTable.get(999) == 1998);
+    }
+
+    SECTION("The maximum load factor must be positive")
+    {
+        REQUIRE_THROWS(testTable.setMaxLoadFactor(0.0f));
+    }
+}
+
+TEST_CASE("Reserve and rehash functions behave as expected", "[HashTable][reserve()][rehash()]")
+{
+    HashTable<int, std::string> testTable(10);
+    testTable.insert(10, "ten");
+    testTable.insert(5, "five");
+    testTable.insert(15, "fifteen");
+
+    SECTION("Reserving space grows the table array without changing its contents")
+    {
+        testTable.reserve(500);
+        REQUIRE(testTable.bucketCount() >= 500);
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(*testTable.get(10) == "ten");
+        REQUIRE(*testTable.get(5) == "five");
+        REQUIRE(*testTable.get(15) == "fifteen");
+    }
+
+    SECTION("Reserving less space than is available does not shrink the table array")
+    {
+        testTable.reserve(1);
+        REQUIRE(testTable.bucketCount() == 10);
+    }
+
+    SECTION("Rehashing never shrinks the table array below the maximum load factor")
+    {
+        testTable.rehash(1);
+        REQUIRE(testTable.bucketCount() == 3);
+        REQUIRE(*testTable.get(15) == "fifteen");
+    }
+
+    SECTION("Load factor reports the number of elements per bucket")
+    {
+        REQUIRE(testTable.loadFactor() == Approx(0.3f));
+    }
+}
+
+unsigned int hashTableTestModulusHash(int key, unsigned int modulus)
+{
+    return (unsigned int)key % modulus;
+}
+
+struct HashTableTestCaseInsensitiveHash
+{
+    size_t operator()(const std::string& key) const
+    {
+        std::string lowered;
+        for (char character : key) lowered += (char)std::tolower(character);
+        return DefaultHash<std::string>()(lowered);
+    }
+};
+
+struct HashTableTestCaseInsensitiveEqual
+{
+    bool operator()(const std::string& first, const std::string& second) const
+    {
+        if (first.size() != second.size()) return false;
+        for (size_t i = 0; i < first.size(); i++)
+        {
+            if (std::tolower(first[i]) != std::tolower(second[i])) return false;
+        }
+        return true;
+    }
+};
+
+TEST_CASE("Hash and key equality functors can be provided as template parameters", "[HashTable][HASH][KEY_EQUAL]")
+{
+    HashTable<std::string, int, HashTableTestCaseInsensitiveHash, HashTableTestCaseInsensitiveEqual> testTable;
+    testTable.insert("Ten", 10);
+
+    SECTION("Lookups use the provided functors")
+    {
+        REQUIRE(*testTable.get("TEN") == 10);
+        REQUIRE(testTable.contains("ten") == true);
+    }
+
+    SECTION("Inserting an equal key overwrites the value")
+    {
+        testTable.insert("tEN", 11);
+        REQUIRE(testTable.size() == 1);
+        REQUIRE(*testTable.get("Ten") == 11);
+    }
+}
+
+TEST_CASE("Hash function pointers passed to the constructor are still used", "[HashTable][HASH]")
+{
+    HashTable<int, std::string, FunctionPointerHash<int>> testTable(10, &hashTableTestModulusHash);
+    testTable.insert(3, "three");
+    testTable.insert(13, "thirteen");
+
+    SECTION("Keys are placed in the buckets chosen by the function")
+    {
+        REQUIRE(testTable.getHash(3) == 3);
+        REQUIRE(testTable.getHash(13) == 3);
+    }
+
+    SECTION("Keys can be retrieved")
+    {
+        REQUIRE(*testTable.get(3) == "three");
+        REQUIRE(*testTable.get(13) == "thirteen");
+    }
+
+    SECTION("Without a function pointer the adapter falls back to the default hash")
+    {
+        HashTable<int, std::string, FunctionPointerHash<int>> defaultTable;
+        for (int i = 0; i < 1000; i++) defaultTable.insert(i, std::to_string(i));
+        REQUIRE(*defaultTable.get(999) == "999");
+        REQUIRE(defaultTable.contains(1000) == false);
+    }
+}
+
+TEST_CASE("Incremental rehashing moves buckets across a few at a time", "[HashTable][setIncrementalRehash()]")
+{
+    HashTable<int, int> testTable(64);
+    testTable.setIncrementalRehash(true, 1);
+    for (int i = 0; i < 65; i++) testTable.insert(i, i);
+
+    SECTION("Growing the table starts an incremental rehash instead of finishing it")
+    {
+        REQUIRE(testTable.isRehashing() == true);
+        REQUIRE(testTable.bucketCount() == 128);
+    }
+
+    SECTION("Every element can be retrieved while the rehash is in progress")
+    {
+        bool allFound = true;
+        for (int i = 0; i < 65; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+        REQUIRE(allFound);
+    }
+
+    SECTION("Elements can be overwritten and removed while the rehash is in progress")
+    {
+        testTable.insert(3, 300);
+        REQUIRE(testTable.remove(4) == true);
+        REQUIRE(testTable.size() == 64);
+        REQUIRE(*testTable.get(3) == 300);
+        REQUIRE(testTable.contains(4) == false);
+    }
+
+    SECTION("Operations on the table finish the rehash eventually")
+    {
+        for (int i = 0; i < 64 && testTable.isRehashing(); i++) testTable.contains(i);
+        REQUIRE(testTable.isRehashing() == false);
+        REQUIRE(testTable.size() == 65);
+        REQUIRE(*testTable.get(64) == 64);
+    }
+
+    SECTION("Clearing the table abandons the rehash")
+    {
+        testTable.clear();
+        REQUIRE(testTable.isRehashing() == false);
+        REQUIRE(testTable.size() == 0);
+        REQUIRE(testTable.get(1) == nullptr);
+    }
+
+    SECTION("Turning incremental rehashing off completes the rehash")
+    {
+        testTable.setIncrementalRehash(false);
+        REQUIRE(testTable.isRehashing() == false);
+        REQUIRE(*testTable.get(0) == 0);
+    }
+}
+
+TEST_CASE("Incremental rehashing keeps every element through repeated growth", "[HashTable][setIncrementalRehash()]")
+{
+    HashTable<int, int> testTable(1);
+    testTable.setIncrementalRehash(true);
+    for (int i = 0; i < 20000; i++) testTable.insert(i, -i);
+
+    bool allFound = true;
+    for (int i = 0; i < 20000; i++) allFound = allFound && *testTable.get(i) == -i;
+
+    REQUIRE(testTable.size() == 20000);
+    REQUIRE(allFound);
+}
+
+struct HashTableTestCountingHash
+{
+    static int calls;
+
+    size_t operator()(int key) const
+    {
+        calls++;
+        return DefaultHash<int>()(key);
+    }
+};
+int HashTableTestCountingHash::calls = 0;
+
+struct HashTableTestCountingEqual
+{
+    static int calls;
+
+    bool operator()(int first, int second) const
+    {
+        calls++;
+        return first == second;
+    }
+};
+int HashTableTestCountingEqual::calls = 0;
+
+TEST_CASE("Nodes store the full hash of their keys", "[HashTable][HashTableNode]")
+{
+    HashTable<int, int, HashTableTestCountingHash, HashTableTestCountingEqual> testTable(1, HashTableTestCountingHash(), HashTableTestCountingEqual(), std::numeric_limits<float>::infinity());
+    for (int i = 0; i < 100; i++) testTable.insert(i, i);
+
+    SECTION("Chain walks only compare keys whose hashes match")
+    {
+        HashTableTestCountingEqual::calls = 0;
+        REQUIRE(*testTable.get(99) == 99);
+        REQUIRE(testTable.contains(1000) == false);
+        REQUIRE(HashTableTestCountingEqual::calls == 1);
+    }
+
+    SECTION("Rehashing does not hash any key again")
+    {
+        HashTableTestCountingHash::calls = 0;
+        testTable.rehash(256);
+        REQUIRE(HashTableTestCountingHash::calls == 0);
+        REQUIRE(*testTable.get(42) == 42);
+    }
+}
+
+TEST_CASE("Try emplace inserts only when the key does not exist", "[HashTable][tryEmplace()]")
+{
+    HashTable<std::string, std::string> testTable;
+    testTable.insert("ten", "10");
+
+    SECTION("A new key is inserted with a value constructed from the arguments")
+    {
+        std::pair<std::string&, bool> result = testTable.tryEmplace("five", 3, '5');
+        REQUIRE(result.second == true);
+        REQUIRE(result.first == "555");
+        REQUIRE(*testTable.get("five") == "555");
+        REQUIRE(testTable.size() == 2);
+    }
+
+    SECTION("An existing key keeps its value")
+    {
+        std::pair<std::string&, bool> result = testTable.tryEmplace("ten", "TEN");
+        REQUIRE(result.second == false);
+        REQUIRE(result.first == "10");
+        REQUIRE(testTable.size() == 1);
+    }
+
+    SECTION("The returned reference refers to the value in the table")
+    {
+        testTable.tryEmplace("ten").first += "0";
+        REQUIRE(*testTable.get("ten") == "100");
+    }
+}
+
+TEST_CASE("Find or insert only calls the factory when the key does not exist", "[HashTable][findOrInsert()]")
+{
+    HashTable<std::string, int> testTable;
+    int factoryCalls = 0;
+    std::string words[] = {"one", "two", "one", "three", "one"};
+    for (const std::string& word : words)
+    {
+        testTable.findOrInsert(word, [&]() { factoryCalls++; return 0; }).first++;
+    }
+
+    REQUIRE(factoryCalls == 3);
+    REQUIRE(*testTable.get("one") == 3);
+    REQUIRE(*testTable.get("two") == 1);
+    REQUIRE(*testTable.get("three") == 1);
+}
+
+TEST_CASE("Insert hashes each key once", "[HashTable][insert()]")
+{
+    HashTable<int, int, HashTableTestCountingHash> testTable(1000);
+    HashTableTestCountingHash::calls = 0;
+    testTable.insert(1, 1);
+    testTable.insert(1, 2);
+
+    REQUIRE(HashTableTestCountingHash::calls == 2);
+    REQUIRE(*testTable.get(1) == 2);
+}
+
+TEST_CASE("Batch lookups behave like individual lookups", "[HashTable][getBatch()][containsBatch()]")
+{
+    HashTable<int, int> testTable;
+    for (int i = 0; i < 500; i += 2) testTable.insert(i, i * 10);
+
+    int keys[200];
+    for (int i = 0; i < 200; i++) keys[i] = i * 3;
+
+    SECTION("Get batch returns a pointer to each value, or null for missing keys")
+    {
+        int* values[200];
+        testTable.getBatch(keys, 200, values);
+
+        bool allMatch = true;
+        for (int i = 0; i < 200; i++) allMatch = allMatch && values[i] == testTable.get(keys[i]);
+        REQUIRE(allMatch);
+        REQUIRE(*values[2] == 60);
+        REQUIRE(values[1] == nullptr);
+    }
+
+    SECTION("Contains batch reports whether each key exists")
+    {
+        bool results[200];
+        testTable.containsBatch(keys, 200, results);
+
+        bool allMatch = true;
+        for (int i = 0; i < 200; i++) allMatch = allMatch && results[i] == testTable.contains(keys[i]);
+        REQUIRE(allMatch);
+    }
+
+    SECTION("Batch lookups find keys during an incremental rehash")
+    {
+        HashTable<int, int> growingTable(64);
+        growingTable.setIncrementalRehash(true, 1);
+        for (int i = 0; i < 65; i++) growingTable.insert(i, i);
+
+        int growingKeys[65];
+        for (int i = 0; i < 65; i++) growingKeys[i] = i;
+        bool results[65];
+        growingTable.containsBatch(growingKeys, 65, results);
+
+        bool allFound = true;
+        for (int i = 0; i < 65; i++) allFound = allFound && results[i];
+        REQUIRE(growingTable.isRehashing() == true);
+        REQUIRE(allFound);
+    }
+}
+
+TEST_CASE("Small tables keep their first elements inline", "[HashTable][SmallHashTable]")
+{
+    SmallHashTable<std::string, std::string, 4> testTable;
+    testTable.insert("one", "1");
+    testTable.insert("two", "2");
+    testTable.insert("three", "3");
+
+    SECTION("A small table allocates nothing until it leaves small mode")
+    {
+        REQUIRE(testTable.isSmall() == true);
+        REQUIRE(testTable.allocatorStatistics().slabCount == 0);
+        REQUIRE(testTable.size() == 3);
+        REQUIRE(*testTable.get("two") == "2");
+        REQUIRE(testTable.contains("four") == false);
+    }
+
+    SECTION("Inserting, overwriting and removing work inline")
+    {
+        testTable.insert("two", "TWO");
+        REQUIRE(testTable.remove("one") == true);
+        REQUIRE(testTable.remove("one") == false);
+        testTable.insert("four", "4");
+        testTable.insert("five", "5");
+        REQUIRE(testTable.isSmall() == true);
+        REQUIRE(testTable.size() == 4);
+        REQUIRE(*testTable.get("two") == "TWO");
+        REQUIRE(*testTable.get("three") == "3");
+        REQUIRE(*testTable.get("five") == "5");
+    }
+
+    SECTION("Inserting past the inline capacity moves every element into buckets")
+    {
+        testTable.insert("four", "4");
+        testTable.insert("five", "5");
+        REQUIRE(testTable.isSmall() == false);
+        REQUIRE(testTable.allocatorStatistics().objectsInUse == 5);
+        REQUIRE(*testTable.get("one") == "1");
+        REQUIRE(*testTable.get("five") == "5");
+        for (int i = 0; i < 100; i++) testTable.insert(std::to_string(i), std::to_string(i * i));
+        REQUIRE(testTable.size() == 105);
+        REQUIRE(*testTable.get("99") == "9801");
+    }
+
+    SECTION("Reserving more elements than fit inline leaves small mode")
+    {
+        testTable.reserve(4);
+        REQUIRE(testTable.isSmall() == true);
+        testTable.reserve(50);
+        REQUIRE(testTable.isSmall() == false);
+        REQUIRE(testTable.bucketCount() >= 50);
+        REQUIRE(*testTable.get("three") == "3");
+    }
+
+    SECTION("Batch lookups and clear work inline")
+    {
+        std::string keys[3] = {"one", "missing", "three"};
+        bool results[3];
+        testTable.containsBatch(keys, 3, results);
+        REQUIRE(results[0] == true);
+        REQUIRE(results[1] == false);
+        REQUIRE(results[2] == true);
+
+        testTable.clear();
+        REQUIRE(testTable.size() == 0);
+        REQUIRE(testTable.contains("one") == false);
+    }
+}
+
+// Counts the comparisons made against a probe that is not a std::string
+struct HashTableTestTransparentEqual
+{
+    using is_transparent = void;
+    static inline int heterogeneousComparisons = 0;
+
+    template<typename LOOKUP_KEY>
+    bool operator()(const std::string& key, const LOOKUP_KEY& lookupKey) const
+    {
+        if (!std::is_same<LOOKUP_KEY, std::string>::value) heterogeneousComparisons++;
+        return key == lookupKey;
+    }
+};
+
+TEST_CASE("Transparent functors allow lookups by other key types", "[HashTable][get()][contains()][remove()]")
+{
+    HashTable<std::string, int, DefaultHash<std::string>, HashTableTestTransparentEqual> testTable;
+    testTable.insert("alpha", 1);
+    testTable.insert("beta", 2);
+    HashTableTestTransparentEqual::heterogeneousComparisons = 0;
+
+    SECTION("String views and C strings are compared without building a key")
+    {
+        REQUIRE(*testTable.get(std::string_view("alpha")) == 1);
+        REQUIRE(testTable.contains("beta") == true);
+        REQUIRE(testTable.contains(std::string_view("gamma")) == false);
+        REQUIRE(HashTableTestTransparentEqual::heterogeneousComparisons >= 2);
+    }
+
+    SECTION("Other key types hash to the same bucket as the key")
+    {
+        REQUIRE(testTable.getHash(std::string_view("beta")) == testTable.getHash(std::string("beta")));
+    }
+
+    SECTION("Removing by another key type removes the element")
+    {
+        REQUIRE(testTable.remove(std::string_view("alpha")) == true);
+        REQUIRE(testTable.remove("alpha") == false);
+        REQUIRE(testTable.size() == 1);
+    }
+
+    SECTION("Small tables compare other key types inline")
+    {
+        SmallHashTable<std::string, int, 4, DefaultHash<std::string>, std::equal_to<>> smallTable;
+        smallTable.insert("alpha", 1);
+        REQUIRE(*smallTable.get(std::string_view("alpha")) == 1);
+        REQUIRE(smallTable.remove("alpha") == true);
+        REQUIRE(smallTable.empty() == true);
+    }
+}
+
+// Counts how many times any instance is copied or moved
+struct HashTableTestCopyCounter
+{
+    static inline int copies = 0;
+    static inline int moves = 0;
+
+    int id = 0;
+    std::string payload;
+
+    HashTableTestCopyCounter(int id, std::string payload = "") : id(id), payload(std::move(payload)) {}
+    HashTableTestCopyCounter(const HashTableTestCopyCounter& other) : id(other.id), payload(other.payload) { copies++; }
+    HashTableTestCopyCounter(HashTableTestCopyCounter&& other) noexcept : id(other.id), payload(std::move(other.payload)) { moves++; }
+    HashTableTestCopyCounter& operator=(const HashTableTestCopyCounter& other) { id = other.id; payload = other.payload; copies++; return *this; }
+    HashTableTestCopyCounter& operator=(HashTableTestCopyCounter&& other) noexcept { id = other.id; payload = std::move(other.payload); moves++; return *this; }
+
+    bool operator==(const HashTableTestCopyCounter& other) const
+    {
+        return id == other.id;
+    }
+
+    static void reset()
+    {
+        copies = 0;
+        moves = 0;
+    }
+};
+
+struct HashTableTestCopyCounterHash
+{
+    size_t operator()(const HashTableTestCopyCounter& key) const
+    {
+        return DefaultHash<int>()(key.id);
+    }
+};
+
+TEST_CASE("Inserting rvalues and emplacing avoid copying keys and values", "[HashTable][insert()][emplace()]")
+{
+    HashTable<HashTableTestCopyCounter, HashTableTestCopyCounter, HashTableTestCopyCounterHash> testTable;
+    HashTableTestCopyCounter key(1);
+    HashTableTestCopyCounter value(10, "payload");
+    HashTableTestCopyCounter::reset();
+
+    SECTION("Inserting lvalues copies the key and value once each")
+    {
+        testTable.insert(key, value);
+        REQUIRE(HashTableTestCopyCounter::copies == 2);
+        REQUIRE(HashTableTestCopyCounter::moves == 0);
+    }
+
+    SECTION("Inserting rvalues moves the key and value once each and copies nothing")
+    {
+        testTable.insert(std::move(key), std::move(value));
+        REQUIRE(HashTableTestCopyCounter::copies == 0);
+        REQUIRE(HashTableTestCopyCounter::moves == 2);
+        REQUIRE(testTable.get(HashTableTestCopyCounter(1))->payload == "payload");
+    }
+
+    SECTION("Overwriting with an rvalue moves the value")
+    {
+        testTable.insert(HashTableTestCopyCounter(1), HashTableTestCopyCounter(10));
+        HashTableTestCopyCounter::reset();
+        testTable.insert(HashTableTestCopyCounter(1), HashTableTestCopyCounter(11, "new"));
+        REQUIRE(HashTableTestCopyCounter::copies == 0);
+        REQUIRE(testTable.size() == 1);
+        REQUIRE(testTable.get(HashTableTestCopyCounter(1))->id == 11);
+    }
+
+    SECTION("Emplacing constructs the value in the node")
+    {
+        std::pair<HashTableTestCopyCounter&, bool> result = testTable.emplace(std::move(key), 12, "emplaced");
+        REQUIRE(result.second == true);
+        REQUIRE(result.first.payload == "emplaced");
+        REQUIRE(HashTableTestCopyCounter::copies == 0);
+        REQUIRE(HashTableTestCopyCounter::moves == 1);
+
+        REQUIRE(testTable.emplace(HashTableTestCopyCounter(1), 13, "overwritten").second == false);
+        REQUIRE(testTable.get(HashTableTestCopyCounter(1))->id == 13);
+        REQUIRE(HashTableTestCopyCounter::copies == 0);
+    }
+
+    SECTION("Try emplace moves an rvalue key only when it is inserted")
+    {
+        testTable.tryEmplace(std::move(key), 14);
+        REQUIRE(HashTableTestCopyCounter::copies == 0);
+        REQUIRE(HashTableTestCopyCounter::moves == 1);
+        REQUIRE(testTable.tryEmplace(HashTableTestCopyCounter(1), 15).second == false);
+        REQUIRE(testTable.get(HashTableTestCopyCounter(1))->id == 14);
+    }
+}
+
+TEST_CASE("Iterators visit every element once", "[HashTable][begin()][end()][erase()]")
+{
+    HashTable<int, int> testTable(16);
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i * 2);
+
+    SECTION("Range-for visits every key and value")
+    {
+        long keySum = 0;
+        size_t count = 0;
+        bool valuesMatch = true;
+        for (auto [key, value] : testTable)
+        {
+            keySum += key;
+            count++;
+            valuesMatch = valuesMatch && value == key * 2;
+        }
+        REQUIRE(count == 1000);
+        REQUIRE(keySum == 999 * 1000 / 2);
+        REQUIRE(valuesMatch);
+    }
+
+    SECTION("Values can be changed through an iterator")
+    {
+        for (auto it = testTable.begin(); it != testTable.end(); ++it) it->value += 1;
+        REQUIRE(*testTable.get(10) == 21);
+    }
+
+    SECTION("Const iterators visit every element, including during an incremental rehash")
+    {
+        HashTable<int, int> growingTable(64);
+        growingTable.setIncrementalRehash(true, 1);
+        for (int i = 0; i < 100; i++) growingTable.insert(i, i);
+        REQUIRE(growingTable.isRehashing() == true);
+
+        const HashTable<int, int>& constTable = growingTable;
+        size_t count = 0;
+        for (HashTable<int, int>::const_iterator it = constTable.begin(); it != constTable.end(); ++it) count++;
+        REQUIRE(count == 100);
+    }
+
+    SECTION("Erasing while iterating removes only the erased elements")
+    {
+        for (auto it = testTable.begin(); it != testTable.end();)
+        {
+            if (it->key % 3 == 0) it = testTable.erase(it);
+            else ++it;
+        }
+        bool correct = true;
+        for (int i = 0; i < 1000; i++) correct = correct && testTable.contains(i) == (i % 3 != 0);
+        REQUIRE(correct);
+        REQUIRE(testTable.size() == 666);
+    }
+
+    SECTION("For each visits every element")
+    {
+        long valueSum = 0;
+        testTable.forEach([&](const int&, int& value) { valueSum += value; value = 0; });
+        REQUIRE(valueSum == 999 * 1000);
+        REQUIRE(*testTable.get(500) == 0);
+    }
+
+    SECTION("An empty table has no elements to iterate")
+    {
+        HashTable<int, int> emptyTable;
+        REQUIRE(emptyTable.begin() == emptyTable.end());
+    }
+}
+
+TEST_CASE("Iterators walk the inline nodes of small tables", "[HashTable][SmallHashTable][erase()]")
+{
+    SmallHashTable<int, std::string, 8> testTable;
+    for (int i = 0; i < 6; i++) testTable.insert(i, std::to_string(i));
+
+    size_t count = 0;
+    for (auto entry : testTable) count += entry.value == std::to_string(entry.key);
+    REQUIRE(count == 6);
+
+    for (auto it = testTable.begin(); it != testTable.end();)
+    {
+        if (it->key % 2 == 0) it = testTable.erase(it);
+        else ++it;
+    }
+    REQUIRE(testTable.size() == 3);
+    REQUIRE(testTable.isSmall() == true);
+    REQUIRE(testTable.contains(1) == true);
+    REQUIRE(testTable.contains(4) == false);
+}
+
+struct HashTableTestOtherHash
+{
+    size_t operator()(int key) const
+    {
+        return ~(size_t)key * 31;
+    }
+};
+
+// A value whose snapshot encoding throws for the text "fail", to interrupt a save
+struct HashTableTestFailingValue
+{
+    std::string text;
+};
+
+template<>
+struct SnapshotCodec<HashTableTestFailingValue>
+{
+    static constexpr uint32_t ENCODING = 100;
+    static constexpr uint32_t SIZE = 0;
+
+    static void write(SnapshotWriter& writer, const HashTableTestFailingValue& value)
+    {
+        if (value.text == "fail") throw std::runtime_error("Could not encode value");
+        SnapshotCodec<std::string>::write(writer, value.text);
+    }
+
+    static HashTableTestFailingValue read(SnapshotReader& reader)
+    {
+        return HashTableTestFailingValue{SnapshotCodec<std::string>::read(reader)};
+    }
+};
+
+TEST_CASE("Snapshots save and load every element", "[HashTable][saveSnapshot()][loadSnapshot()]")
+{
+    const std::string path = "HashTableSnapshotTest.bin";
+
+    SECTION("Trivially copyable keys and values survive a round trip")
+    {
+        HashTable<int, double> savedTable;
+        for (int i = 0; i < 100000; i++) savedTable.insert(i, i * 0.5);
+        savedTable.saveSnapshot(path);
+
+        HashTable<int, double> loadedTable;
+        loadedTable.insert(-1, -1.0);
+        loadedTable.loadSnapshot(path);
+        bool allFound = true;
+        for (int i = 0; i < 100000; i++) allFound = allFound && loadedTable.get(i) != nullptr && *loadedTable.get(i) == i * 0.5;
+        REQUIRE(allFound);
+        REQUIRE(loadedTable.size() == 100000);
+        REQUIRE(loadedTable.contains(-1) == false);
+        REQUIRE(loadedTable.bucketCount() == savedTable.bucketCount());
+    }
+
+    SECTION("Strings survive a round trip, including into and out of small tables")
+    {
+        SmallHashTable<std::string, std::string, 4> savedTable;
+        savedTable.insert("one", "1");
+        savedTable.insert("", "empty");
+        savedTable.saveSnapshot(path);
+
+        HashTable<std::string, std::string> loadedTable;
+        loadedTable.loadSnapshot(path);
+        REQUIRE(loadedTable.size() == 2);
+        REQUIRE(*loadedTable.get("one") == "1");
+        REQUIRE(*loadedTable.get("") == "empty");
+
+        for (int i = 0; i < 100; i++) loadedTable.insert(std::to_string(i), std::string(i, 'x'));
+        loadedTable.saveSnapshot(path);
+        SmallHashTable<std::string, std::string, 4> smallTable;
+        smallTable.loadSnapshot(path);
+        REQUIRE(smallTable.isSmall() == false);
+        REQUIRE(smallTable.size() == 102);
+        REQUIRE(*smallTable.get("99") == std::string(99, 'x'));
+    }
+
+    SECTION("A table that never grows keeps its saved bucket count")
+    {
+        HashTable<int, int> savedTable(64, nullptr, std::numeric_limits<float>::infinity());
+        for (int i = 0; i < 100; i++) savedTable.insert(i, i);
+        savedTable.saveSnapshot(path);
+
+        HashTable<int, int> loadedTable(1, nullptr, std::numeric_limits<float>::infinity());
+        loadedTable.loadSnapshot(path);
+        bool allFound = true;
+        for (int i = 0; i < 100; i++) allFound = allFound && loadedTable.get(i) != nullptr && *loadedTable.get(i) == i;
+        REQUIRE(allFound);
+        REQUIRE(loadedTable.bucketCount() == 64);
+    }
+
+    SECTION("A save that fails part way leaves the previous snapshot in place")
+    {
+        HashTable<int, HashTableTestFailingValue> savedTable;
+        savedTable.insert(1, HashTableTestFailingValue{"one"});
+        savedTable.saveSnapshot(path);
+
+        for (int i = 2; i < 1000; i++) savedTable.insert(i, HashTableTestFailingValue{std::to_string(i)});
+        savedTable.insert(500, HashTableTestFailingValue{"fail"});
+        REQUIRE_THROWS_AS(savedTable.saveSnapshot(path), std::runtime_error);
+
+        HashTable<int, HashTableTestFailingValue> loadedTable;
+        loadedTable.loadSnapshot(path);
+        REQUIRE(loadedTable.size() == 1);
+        REQUIRE(loadedTable.get(1)->text == "one");
+        std::FILE* temporaryFile = std::fopen((path + ".tmp").c_str(), "rb");
+        REQUIRE(temporaryFile == nullptr);
+    }
+
+    SECTION("A snapshot written with another hash function is hashed again")
+    {
+        HashTable<int, int> savedTable;
+        for (int i = 0; i < 1000; i++) savedTable.insert(i, -i);
+        savedTable.saveSnapshot(path);
+
+        HashTable<int, int, HashTableTestOtherHash> loadedTable;
+        loadedTable.loadSnapshot(path);
+        bool allFound = true;
+        for (int i = 0; i < 1000; i++) allFound = allFound && loadedTable.get(i) != nullptr && *loadedTable.get(i) == -i;
+        REQUIRE(allFound);
+    }
+
+    SECTION("Loading a file that is not a matching snapshot throws")
+    {
+        HashTable<int, int> savedTable;
+        for (int i = 0; i < 10; i++) savedTable.insert(i, i);
+        savedTable.saveSnapshot(path);
+
+        HashTable<long long, int> otherKeyTable;
+        REQUIRE_THROWS_AS(otherKeyTable.loadSnapshot(path), std::runtime_error);
+
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        std::fseek(file, 0, SEEK_END);
+        long length = std::ftell(file);
+        std::fclose(file);
+        std::vector<char> bytes(length);
+        file = std::fopen(path.c_str(), "rb");
+        REQUIRE(std::fread(bytes.data(), 1, bytes.size(), file) == bytes.size());
+        std::fclose(file);
+
+        // Cut off part of the last element, which the header cannot show
+        // when the elements vary in size
+        HashTable<int, std::string> stringTable;
+        for (int i = 0; i < 10; i++) stringTable.insert(i, std::to_string(i));
+        stringTable.saveSnapshot(path);
+        file = std::fopen(path.c_str(), "rb");
+        std::vector<char> stringBytes(4096);
+        stringBytes.resize(std::fread(stringBytes.data(), 1, stringBytes.size(), file));
+        std::fclose(file);
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(stringBytes.data(), 1, stringBytes.size() - 1, file);
+        std::fclose(file);
+        HashTable<int, std::string> truncatedStringTable;
+        truncatedStringTable.insert(100, "100");
+        REQUIRE_THROWS_AS(truncatedStringTable.loadSnapshot(path), std::runtime_error);
+        REQUIRE(truncatedStringTable.size() == 0);
+
+        // Claim a string far longer than the file, which is rejected before
+        // anything is allocated for it. The first length follows the header,
+        // the first hash and the first key.
+        std::vector<char> lengthBytes = stringBytes;
+        uint64_t hugeLength = (uint64_t)1 << 60;
+        std::memcpy(&lengthBytes[SnapshotHeader::BYTES + sizeof(uint64_t) + sizeof(int)], &hugeLength, sizeof(hugeLength));
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(lengthBytes.data(), 1, lengthBytes.size(), file);
+        std::fclose(file);
+        truncatedStringTable.insert(100, "100");
+        REQUIRE_THROWS_AS(truncatedStringTable.loadSnapshot(path), std::runtime_error);
+        REQUIRE(truncatedStringTable.size() == 0);
+
+        // Cut off a whole element, which the header check rejects before
+        // the table is touched
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size() - 16, file);
+        std::fclose(file);
+        HashTable<int, int> truncatedTable;
+        truncatedTable.insert(100, 100);
+        REQUIRE_THROWS_AS(truncatedTable.loadSnapshot(path), std::runtime_error);
+        REQUIRE(truncatedTable.size() == 1);
+
+        // Claim far more elements than the file holds
+        std::vector<char> countBytes = bytes;
+        uint64_t hugeCount = (uint64_t)1 << 60;
+        std::memcpy(&countBytes[24], &hugeCount, sizeof(hugeCount));
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(countBytes.data(), 1, countBytes.size(), file);
+        std::fclose(file);
+        REQUIRE_THROWS_AS(truncatedTable.loadSnapshot(path), std::runtime_error);
+        REQUIRE(truncatedTable.size() == 1);
+        REQUIRE(*truncatedTable.get(100) == 100);
+
+        // Claim a huge bucket count, which is limited to what the elements need
+        std::vector<char> bucketBytes = bytes;
+        uint64_t hugeBucketCount = (uint64_t)1 << 60;
+        std::memcpy(&bucketBytes[32], &hugeBucketCount, sizeof(hugeBucketCount));
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bucketBytes.data(), 1, bucketBytes.size(), file);
+        std::fclose(file);
+        truncatedTable.loadSnapshot(path);
+        REQUIRE(truncatedTable.size() == 10);
+        REQUIRE(*truncatedTable.get(9) == 9);
+        REQUIRE(truncatedTable.bucketCount() <= 40);
+
+        // Change the version
+        bytes[4] = 99;
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+        REQUIRE_THROWS_AS(truncatedTable.loadSnapshot(path), std::runtime_error);
+
+        REQUIRE_THROWS_AS(truncatedTable.loadSnapshot("MissingHashTableSnapshot.bin"), std::runtime_error);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Bulk build inserts every pair on several threads", "[HashTable][bulkBuild()]")
+{
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < 200000; i++) pairs.emplace_back(i % 150000, i);
+
+    SECTION("The last value of a duplicate key wins")
+    {
+        HashTable<int, int> testTable;
+        testTable.insert(-1, -1);
+        testTable.insert(5, -5);
+        testTable.bulkBuild(pairs.begin(), pairs.end(), 4);
+
+        bool allFound = true;
+        for (int i = 0; i < 150000; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == (i < 50000 ? i + 150000 : i);
+        REQUIRE(allFound);
+        REQUIRE(testTable.size() == 150001);
+        REQUIRE(*testTable.get(-1) == -1);
+        REQUIRE(testTable.loadFactor() <= testTable.getMaxLoadFactor());
+    }
+
+    SECTION("A combiner folds duplicate values in input order")
+    {
+        HashTable<int, long long> testTable;
+        testTable.insert(0, 1000000);
+        std::vector<std::pair<int, long long>> counts;
+        for (int i = 0; i < 100000; i++) counts.emplace_back(i % 1000, 1);
+        testTable.bulkBuild(counts.begin(), counts.end(), 8, [](long long& combined, long long next) { combined += next; });
+
+        bool allCounted = true;
+        for (int i = 1; i < 1000; i++) allCounted = allCounted && *testTable.get(i) == 100;
+        REQUIRE(allCounted);
+        REQUIRE(*testTable.get(0) == 1000100);
+        REQUIRE(testTable.size() == 1000);
+    }
+
+    SECTION("Pairs can be moved into the table")
+    {
+        std::vector<std::pair<std::string, std::string>> stringPairs;
+        for (int i = 0; i < 20000; i++) stringPairs.emplace_back("key" + std::to_string(i), std::string(100, 'a' + i % 26));
+        HashTable<std::string, std::string> testTable;
+        testTable.bulkBuild(std::make_move_iterator(stringPairs.begin()), std::make_move_iterator(stringPairs.end()), 3);
+
+        REQUIRE(testTable.size() == 20000);
+        REQUIRE(*testTable.get("key19999") == std::string(100, 'a' + 19999 % 26));
+        REQUIRE(stringPairs[0].second.empty());
+    }
+
+    SECTION("Small tables take pairs that fit inline one at a time")
+    {
+        SmallHashTable<int, int, 8> smallTable;
+        smallTable.bulkBuild(pairs.begin(), pairs.begin() + 4);
+        REQUIRE(smallTable.isSmall() == true);
+        REQUIRE(*smallTable.get(3) == 3);
+
+        smallTable.bulkBuild(pairs.begin(), pairs.end(), 2);
+        REQUIRE(smallTable.isSmall() == false);
+        REQUIRE(smallTable.size() == 150000);
+        REQUIRE(*smallTable.get(149999) == 149999);
+    }
+
+    SECTION("Small tables move pairs that fit inline")
+    {
+        std::vector<std::pair<std::string, std::string>> stringPairs;
+        for (int i = 0; i < 4; i++) stringPairs.emplace_back("key" + std::to_string(i), std::string(100, 'a' + i));
+        SmallHashTable<std::string, std::string, 8> smallTable;
+        smallTable.bulkBuild(std::make_move_iterator(stringPairs.begin()), std::make_move_iterator(stringPairs.end()));
+
+        REQUIRE(smallTable.isSmall() == true);
+        REQUIRE(*smallTable.get("key3") == std::string(100, 'd'));
+        REQUIRE(stringPairs[0].first.empty());
+        REQUIRE(stringPairs[0].second.empty());
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file MappedHashTableTests.cpp
+ * @brief Unit tests for a read-only hash table served from a memory-mapped file
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../MappedHashTable.hpp"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Mapped table finds every element of the table it was built from", "[MappedHashTable][get()]")
+{
+    const std::string path = "MappedHashTableTest.bin";
+
+    SECTION("Trivially copyable keys and values are found in the mapping")
+    {
+        HashTable<int, double> sourceTable;
+        for (int i = 0; i < 100000; i++) sourceTable.insert(i * 3, i * 0.25);
+        MappedHashTableBuilder<int, double>(sourceTable).write(path);
+
+        MappedHashTable<int, double> testTable(path);
+        bool allFound = true;
+        bool noneFound = true;
+        for (int i = 0; i < 100000; i++)
+        {
+            allFound = allFound && testTable.get(i * 3) != nullptr && *testTable.get(i * 3) == i * 0.25;
+            noneFound = noneFound && !testTable.contains(i * 3 + 1);
+        }
+        REQUIRE(allFound);
+        REQUIRE(noneFound);
+        REQUIRE(testTable.size() == 100000);
+        REQUIRE(testTable.bucketCount() == 131072);
+
+        SECTION("Several tables can map the same file")
+        {
+            MappedHashTable<int, double> otherTable(path);
+            REQUIRE(*otherTable.get(300) == 25.0);
+            REQUIRE(*testTable.get(300) == 25.0);
+        }
+
+        SECTION("Moving a table moves the mapping")
+        {
+            MappedHashTable<int, double> movedTable(std::move(testTable));
+            REQUIRE(*movedTable.get(3) == 0.25);
+            REQUIRE(testTable.get(3) == nullptr);
+            REQUIRE(testTable.size() == 0);
+        }
+    }
+
+    SECTION("String keys are found by string view")
+    {
+        HashTable<std::string, int> sourceTable;
+        for (int i = 0; i < 1000; i++) sourceTable.insert("key" + std::to_string(i), i);
+        sourceTable.insert("", -1);
+        MappedHashTableBuilder<std::string, int>(sourceTable).write(path);
+
+        MappedHashTable<std::string, int> testTable(path);
+        bool allFound = true;
+        for (int i = 0; i < 1000; i++) allFound = allFound && testTable.get("key" + std::to_string(i)) != nullptr && *testTable.get("key" + std::to_string(i)) == i;
+        REQUIRE(allFound);
+        REQUIRE(*testTable.get("") == -1);
+        REQUIRE(testTable.get("key1000") == nullptr);
+        REQUIRE(testTable.get(std::string_view("key12", 4)) != nullptr);
+
+        size_t visited = 0;
+        testTable.forEach([&](std::string_view key, int value) { visited += *sourceTable.get(std::string(key)) == value; });
+        REQUIRE(visited == 1001);
+    }
+
+    SECTION("An empty table maps to an empty file")
+    {
+        HashTable<int, int> sourceTable;
+        MappedHashTableBuilder<int, int>(sourceTable).write(path);
+
+        MappedHashTable<int, int> testTable(path);
+        REQUIRE(testTable.empty() == true);
+        REQUIRE(testTable.get(0) == nullptr);
+        std::stringstream outputStream;
+        testTable.print(outputStream);
+        REQUIRE(outputStream.str() == "");
+    }
+
+    std::remove(path.c_str());
+}
+
+struct MappedHashTableTestOtherHash
+{
+    size_t operator()(int key) const
+    {
+        return ~(size_t)key * 31;
+    }
+};
+
+TEST_CASE("Mapped table rejects files it cannot serve", "[MappedHashTable]")
+{
+    const std::string path = "MappedHashTableTest.bin";
+    HashTable<int, int> sourceTable;
+    for (int i = 0; i < 100; i++) sourceTable.insert(i, i);
+    MappedHashTableBuilder<int, int>(sourceTable).write(path);
+
+    SECTION("Files written for other types or another hash function are rejected")
+    {
+        REQUIRE_THROWS_AS((MappedHashTable<int, long long>(path)), std::runtime_error);
+        REQUIRE_THROWS_AS((MappedHashTable<std::string, int>(path)), std::runtime_error);
+        REQUIRE_THROWS_AS((MappedHashTable<int, int, MappedHashTableTestOtherHash>(path)), std::runtime_error);
+    }
+
+    SECTION("Missing, truncated and foreign files are rejected")
+    {
+        REQUIRE_THROWS_AS((MappedHashTable<int, int>("MissingMappedHashTable.bin")), std::runtime_error);
+
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        std::vector<char> bytes(4096);
+        bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+        std::fclose(file);
+
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size() - 8, file);
+        std::fclose(file);
+        REQUIRE_THROWS_AS((MappedHashTable<int, int>(path)), std::runtime_error);
+
+        file = std::fopen(path.c_str(), "wb");
+        std::fwrite("not a table", 1, 11, file);
+        std::fclose(file);
+        REQUIRE_THROWS_AS((MappedHashTable<int, int>(path)), std::runtime_error);
+    }
+
+    std::remove(path.c_str());
+}
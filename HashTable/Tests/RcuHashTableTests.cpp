@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file RcuHashTableTests.cpp
+ * @brief Unit tests for a read-mostly hash table implementation of a key/value dictionary with wait-free readers
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../RcuHashTable.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("RCU hash table read passes the value without copying it", "[RcuHashTable][read()]")
+{
+    RcuHashTable<int, std::string> testTable(4);
+    testTable.insert(15, "fifteen");
+
+    size_t length = 0;
+    REQUIRE(testTable.read(15, [&](const std::string& value) { length = value.size(); }) == true);
+    REQUIRE(testTable.read(20, [&](const std::string& value) { length = value.size(); }) == false);
+    REQUIRE(length == 7);
+}
+
+TEST_CASE("RCU hash table array grows to respect the maximum load factor", "[RcuHashTable][insert()]")
+{
+    RcuHashTable<int, std::string> testTable(4);
+    for (int i = 0; i < 100; i++) testTable.insert(i, std::to_string(i));
+
+    REQUIRE(testTable.size() == 100);
+    REQUIRE(testTable.bucketCount() >= 100);
+    REQUIRE(*testTable.get(99) == "99");
+    REQUIRE(*testTable.get(0) == "0");
+}
+
+TEST_CASE("RCU hash table readers see consistent values while writers update", "[RcuHashTable]")
+{
+    RcuHashTable<int, std::vector<int>> testTable(2);
+    for (int key = 0; key < 100; key++) testTable.insert(key, std::vector<int>(8, key));
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> allConsistent{true};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+    {
+        readers.emplace_back([&]()
+        {
+            while (!stop)
+            {
+                for (int key = 0; key < 100; key++)
+                {
+                    testTable.read(key, [&](const std::vector<int>& value)
+                    {
+                        // Every element of a value is written together
+                        for (int element : value) if (element != value[0]) allConsistent = false;
+                    });
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 200; round++)
+    {
+        for (int key = 0; key < 100; key += 7) testTable.insert(key, std::vector<int>(8, round));
+        testTable.remove(round % 100);
+        testTable.insert(round % 100, std::vector<int>(8, -round));
+        testTable.insert(1000 + round, std::vector<int>(8, round));
+    }
+    stop = true;
+    for (std::thread& reader : readers) reader.join();
+
+    REQUIRE(allConsistent);
+    REQUIRE(testTable.size() == 300);
+    REQUIRE((*testTable.get(1199))[0] == 199);
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file RobinHoodHashTableTests.cpp
+ * @brief Unit tests for an open addressing Robin Hood hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../RobinHoodHashTable.hpp"
+
+TEST_CASE("Robin Hood table holds a high load factor", "[RobinHoodHashTable][insert()]")
+{
+    RobinHoodHashTable<int, int> testTable(16, 0.95f);
+    for (int i = 0; i < 10000; i++) testTable.insert(i * 7, i);
+
+    bool allFound = true;
+    for (int i = 0; i < 10000; i++) allFound = allFound && testTable.get(i * 7) != nullptr && *testTable.get(i * 7) == i;
+
+    REQUIRE(testTable.size() == 10000);
+    REQUIRE(allFound);
+    REQUIRE(testTable.loadFactor() <= 0.95f);
+    REQUIRE(testTable.loadFactor() > 0.45f);
+}
+
+TEST_CASE("Robin Hood table grows normally under a very low maximum load factor", "[RobinHoodHashTable][insert()]")
+{
+    RobinHoodHashTable<int, int> testTable(16, 0.05f);
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i);
+
+    bool allFound = true;
+    for (int i = 0; i < 1000; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+    REQUIRE(testTable.size() == 1000);
+    REQUIRE(allFound);
+    REQUIRE(testTable.loadFactor() <= 0.05f);
+}
+
+struct RobinHoodHashTableTestConstantHash
+{
+    size_t operator()(int) const
+    {
+        return 42;
+    }
+};
+
+TEST_CASE("Robin Hood insert throws once too many keys share a hash", "[RobinHoodHashTable][insert()]")
+{
+    RobinHoodHashTable<int, int, RobinHoodHashTableTestConstantHash> testTable;
+    int inserted = 0;
+    REQUIRE_THROWS_AS([&]() { for (; inserted < 300; inserted++) testTable.insert(inserted, inserted); }(), std::overflow_error);
+
+    // Every key inserted before the throw is still there, and nothing else
+    bool allFound = true;
+    for (int i = 0; i < inserted; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+    REQUIRE(inserted == 254);
+    REQUIRE(testTable.size() == 254);
+    REQUIRE(allFound);
+    REQUIRE(testTable.contains(254) == false);
+}
+
+TEST_CASE("Robin Hood remove shifts entries back without leaving tombstones", "[RobinHoodHashTable][remove()]")
+{
+    RobinHoodHashTable<int, int> testTable(8, 1.0f);
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i);
+
+    SECTION("Removing keys leaves every other key reachable")
+    {
+        for (int i = 0; i < 1000; i += 2) REQUIRE(testTable.remove(i) == true);
+
+        bool remainingFound = true;
+        bool removedMissing = true;
+        for (int i = 0; i < 1000; i++)
+        {
+            if (i % 2 == 0) removedMissing = removedMissing && !testTable.contains(i);
+            else remainingFound = remainingFound && *testTable.get(i) == i;
+        }
+        REQUIRE(testTable.size() == 500);
+        REQUIRE(remainingFound);
+        REQUIRE(removedMissing);
+    }
+
+    SECTION("Removing a key that does not exist returns false")
+    {
+        REQUIRE(testTable.remove(5000) == false);
+        REQUIRE(testTable.size() == 1000);
+    }
+}
@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file ShardedHashTableTests.cpp
+ * @brief Unit tests for per-thread hash table shards that merge into one hash table
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../ShardedHashTable.hpp"
+#include <thread>
+#include <vector>
+
+TEST_CASE("Sharded hash table shards can be read together", "[ShardedHashTable]")
+{
+    ShardedHashTable<int, int> testTable(3);
+    testTable.shard(0).insert(1, 10);
+    testTable.shard(1).insert(1, 11);
+    testTable.shard(2).insert(2, 22);
+
+    SECTION("The highest numbered shard holding a key wins")
+    {
+        REQUIRE(*testTable.get(1) == 11);
+        REQUIRE(*testTable.get(2) == 22);
+        REQUIRE(testTable.get(3) == nullptr);
+        REQUIRE(testTable.contains(2) == true);
+    }
+
+    SECTION("Values can be combined across shards")
+    {
+        REQUIRE(*testTable.get(1, [](int& combined, const int& next) { combined += next; }) == 21);
+        REQUIRE(testTable.get(3, [](int& combined, const int& next) { combined += next; }) == std::nullopt);
+    }
+
+    SECTION("Size counts every shard")
+    {
+        REQUIRE(testTable.size() == 3);
+        testTable.clear();
+        REQUIRE(testTable.empty() == true);
+    }
+
+    SECTION("Shard indexes are checked")
+    {
+        REQUIRE_THROWS_AS(testTable.shard(3), std::out_of_range);
+    }
+}
+
+TEST_CASE("Sharded hash table merges shards filled on separate threads", "[ShardedHashTable][merge()]")
+{
+    const int threadCount = 4;
+    const int keysPerThread = 5000;
+    ShardedHashTable<int, int> testTable(threadCount, 16);
+
+    // Every thread counts the same overlapping range of keys
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&testTable, t]()
+        {
+            HashTable<int, int>& shard = testTable.shard(t);
+            for (int i = 0; i < keysPerThread; i++)
+            {
+                int key = t * (keysPerThread / 2) + i;
+                shard.findOrInsert(key, []() { return 0; }).first++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    SECTION("Combining sums the values of duplicate keys")
+    {
+        HashTable<int, int> merged;
+        testTable.merge(merged, [](int& combined, const int& next) { combined += next; }, threadCount);
+
+        bool allCorrect = true;
+        int expectedKeys = (threadCount + 1) * (keysPerThread / 2);
+        for (int key = 0; key < expectedKeys; key++)
+        {
+            int expected = (key < keysPerThread / 2 || key >= threadCount * (keysPerThread / 2)) ? 1 : 2;
+            allCorrect = allCorrect && merged.get(key) != nullptr && *merged.get(key) == expected;
+        }
+        REQUIRE(allCorrect);
+        REQUIRE(merged.size() == (size_t)expectedKeys);
+        REQUIRE(merged.allocatorStatistics().objectsInUse == (size_t)expectedKeys);
+        REQUIRE(merged.loadFactor() <= merged.getMaxLoadFactor());
+
+        // The elements were copied, so the shards still hold them
+        REQUIRE(testTable.size() == (size_t)(threadCount * keysPerThread));
+        REQUIRE(*testTable.shard(0).get(0) == 1);
+    }
+
+    SECTION("Merging keeps the existing contents of the destination")
+    {
+        HashTable<int, int> merged;
+        merged.insert(0, 100);
+        merged.insert(-1, -1);
+        testTable.merge(merged, [](int& combined, const int& next) { combined += next; }, 3);
+        REQUIRE(*merged.get(0) == 101);
+        REQUIRE(*merged.get(-1) == -1);
+
+        // The destination still works as a normal table afterwards
+        merged.insert(-2, -2);
+        REQUIRE(merged.remove(0) == true);
+        REQUIRE(*merged.get(-2) == -2);
+    }
+
+    SECTION("Without a combiner the highest numbered shard wins")
+    {
+        testTable.shard(0).insert(keysPerThread, -10);
+        testTable.shard(2).insert(keysPerThread, -12);
+        HashTable<int, int> merged;
+        testTable.merge(merged);
+        REQUIRE(*merged.get(keysPerThread) == -12);
+    }
+}
+
+struct ShardedHashTableTestSeededHash
+{
+    size_t seed = 0;
+
+    size_t operator()(int key) const
+    {
+        return DefaultHash<int>()(key) ^ seed;
+    }
+};
+
+TEST_CASE("Sharded hash table only merges into a table that hashes keys the same way", "[ShardedHashTable][merge()]")
+{
+    ShardedHashTableTestSeededHash shardHash{1};
+    ShardedHashTable<int, int, ShardedHashTableTestSeededHash> testTable(2, 100, shardHash);
+    for (int i = 0; i < 1000; i++) testTable.shard(i % 2).insert(i, i);
+
+    SECTION("A destination with another seed is rejected before anything is merged")
+    {
+        HashTable<int, int, ShardedHashTableTestSeededHash> merged(100, ShardedHashTableTestSeededHash{2});
+        REQUIRE_THROWS_AS(testTable.merge(merged), std::invalid_argument);
+        REQUIRE(merged.size() == 0);
+    }
+
+    SECTION("A destination built from the same hasher finds every merged key")
+    {
+        HashTable<int, int, ShardedHashTableTestSeededHash> merged(100, shardHash);
+        testTable.merge(merged, (size_t)2);
+        bool allFound = true;
+        for (int i = 0; i < 1000; i++) allFound = allFound && merged.get(i) != nullptr && *merged.get(i) == i;
+        REQUIRE(allFound);
+    }
+}
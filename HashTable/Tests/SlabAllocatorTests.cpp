@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SlabAllocatorTests.cpp
+ * @brief Unit tests for a slab allocator of fixed-size objects
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../SlabAllocator.hpp"
+#include "../HashTable.hpp"
+
+TEST_CASE("Slab allocator hands out storage from slabs", "[SlabAllocator][allocate()]")
+{
+    SlabAllocator<long> allocator(4, 8);
+    long* first = allocator.allocate();
+    long* second = allocator.allocate();
+
+    SECTION("Storage is carved out of a slab in order")
+    {
+        REQUIRE(second == first + 1);
+        REQUIRE(allocator.statistics().slabCount == 1);
+        REQUIRE(allocator.statistics().objectsInUse == 2);
+    }
+
+    SECTION("Each new slab is larger than the last, up to the maximum")
+    {
+        for (int i = 0; i < 30; i++) allocator.allocate();
+        REQUIRE(allocator.statistics().slabCount == 5);
+        REQUIRE(allocator.statistics().objectCapacity == 4 + 8 + 8 + 8 + 8);
+    }
+
+    SECTION("Freed storage is reused before new storage")
+    {
+        allocator.deallocate(first);
+        REQUIRE(allocator.statistics().freeListLength == 1);
+        REQUIRE(allocator.allocate() == first);
+        REQUIRE(allocator.statistics().freeListLength == 0);
+        REQUIRE(allocator.statistics().totalAllocations == 3);
+    }
+
+    SECTION("Absorbing another allocator takes over its slabs")
+    {
+        SlabAllocator<long> other(4, 8);
+        long* absorbed = other.allocate();
+        allocator.absorb(other);
+        REQUIRE(allocator.statistics().slabCount == 2);
+        REQUIRE(allocator.statistics().objectsInUse == 3);
+        REQUIRE(allocator.statistics().freeListLength == 3);
+        REQUIRE(other.statistics().slabCount == 0);
+        allocator.deallocate(absorbed);
+        REQUIRE(allocator.allocate() == absorbed);
+    }
+
+    SECTION("Releasing frees every slab at once")
+    {
+        allocator.release();
+        REQUIRE(allocator.statistics().slabCount == 0);
+        REQUIRE(allocator.statistics().objectsInUse == 0);
+        REQUIRE(allocator.statistics().bytesReserved == 0);
+    }
+}
+
+TEST_CASE("Hash table nodes come from the table's slab allocator", "[SlabAllocator][HashTable]")
+{
+    HashTable<int, std::string> testTable;
+    for (int i = 0; i < 100; i++) testTable.insert(i, std::to_string(i));
+
+    SECTION("Every node is counted by the allocator statistics")
+    {
+        REQUIRE(testTable.allocatorStatistics().objectsInUse == 100);
+        REQUIRE(testTable.allocatorStatistics().slabCount < 100);
+    }
+
+    SECTION("Removed nodes are reused by later inserts")
+    {
+        for (int i = 0; i < 50; i++) testTable.remove(i);
+        size_t capacity = testTable.allocatorStatistics().objectCapacity;
+        for (int i = 100; i < 150; i++) testTable.insert(i, std::to_string(i));
+        REQUIRE(testTable.allocatorStatistics().objectCapacity == capacity);
+        REQUIRE(*testTable.get(149) == "149");
+    }
+
+    SECTION("Clearing the table releases every slab")
+    {
+        testTable.clear();
+        REQUIRE(testTable.allocatorStatistics().slabCount == 0);
+        testTable.insert(1, "one");
+        REQUIRE(*testTable.get(1) == "one");
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SplitOrderedHashTableTests.cpp
+ * @brief Unit tests for a lock-free, split-ordered hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../SplitOrderedHashTable.hpp"
+#include <thread>
+#include <vector>
+
+TEST_CASE("Split-ordered hash table grows without losing elements", "[SplitOrderedHashTable]")
+{
+    SplitOrderedHashTable<int, int> testTable(2, 1.0f);
+    for (int i = 0; i < 10000; i++) testTable.insert(i, i * 2);
+
+    bool allFound = true;
+    for (int i = 0; i < 10000; i++) allFound = allFound && testTable.get(i) == i * 2;
+
+    REQUIRE(allFound);
+    REQUIRE(testTable.size() == 10000);
+    REQUIRE(testTable.bucketCount() >= 8192);
+}
+
+TEST_CASE("Split-ordered hash table handles many threads at once", "[SplitOrderedHashTable]")
+{
+    SplitOrderedHashTable<int, int> testTable(4);
+    const int threadCount = 8;
+    const int keysPerThread = 5000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&testTable, t]()
+        {
+            for (int i = 0; i < keysPerThread; i++)
+            {
+                int key = t * keysPerThread + i;
+                testTable.insert(key, key);
+                testTable.get(key / 2);
+                testTable.insert(key % 100, i);
+                if (i % 3 == 0) testTable.remove(key);
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    bool allCorrect = true;
+    for (int key = 100; key < threadCount * keysPerThread; key++)
+    {
+        bool removed = (key % keysPerThread) % 3 == 0;
+        allCorrect = allCorrect && (removed ? !testTable.contains(key) : testTable.get(key) == key);
+    }
+
+    REQUIRE(allCorrect);
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file StaticHashTableTests.cpp
+ * @brief Unit tests for an immutable hash table built at compile time
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../StaticHashTable.hpp"
+#include <string>
+#include <string_view>
+
+namespace StaticHashTableTests
+{
+    constexpr auto opcodes = makeStaticHashTable<std::string_view, int>({
+        {"GET", 1}, {"PUT", 2}, {"POST", 3}, {"DELETE", 4}, {"HEAD", 5}, {"OPTIONS", 6}, {"PATCH", 7}
+    });
+
+    // Every lookup here is evaluated by the compiler
+    static_assert(*opcodes.get("GET") == 1);
+    static_assert(*opcodes.get("PATCH") == 7);
+    static_assert(opcodes.contains("OPTIONS"));
+    static_assert(!opcodes.contains("TRACE"));
+    static_assert(opcodes.get("") == nullptr);
+    static_assert(opcodes.size() == 7);
+    static_assert(opcodes.bucketCount() == 8);
+
+    constexpr std::pair<int, int> squares[] = {
+        {0, 0}, {1, 1}, {2, 4}, {3, 9}, {4, 16}, {5, 25}, {6, 36}, {7, 49}, {8, 64}, {9, 81},
+        {10, 100}, {11, 121}, {12, 144}, {13, 169}, {14, 196}, {15, 225}, {16, 256}, {17, 289}
+    };
+    constexpr StaticHashTable<int, int, 18> squareTable(squares);
+}
+
+TEST_CASE("Static hash table finds every key it was built from", "[StaticHashTable][get()]")
+{
+    using StaticHashTableTests::opcodes;
+    using StaticHashTableTests::squareTable;
+
+    SECTION("Keys given at compile time are found at run time")
+    {
+        std::string put = "PUT";
+        REQUIRE(*opcodes.get(put) == 2);
+        REQUIRE(*opcodes.get(std::string("DELETE")) == 4);
+        REQUIRE(opcodes.empty() == false);
+    }
+
+    SECTION("Keys that were never given are not found")
+    {
+        std::string trace = "TRACE";
+        REQUIRE(opcodes.get(trace) == nullptr);
+        REQUIRE(opcodes.contains("get") == false);
+    }
+
+    SECTION("Every slot left over rejects keys that are not in the table")
+    {
+        bool allFound = true;
+        bool noneFound = true;
+        for (int i = 0; i < 18; i++) allFound = allFound && squareTable.get(i) != nullptr && *squareTable.get(i) == i * i;
+        for (int i = 18; i < 10000; i++) noneFound = noneFound && !squareTable.contains(i) && !squareTable.contains(-i);
+        REQUIRE(allFound);
+        REQUIRE(noneFound);
+        REQUIRE(squareTable.bucketCount() == 32);
+    }
+}
+
+TEST_CASE("Static hash table places larger tables at compile time", "[StaticHashTable]")
+{
+    constexpr auto testTable = makeStaticHashTable<int, int>({
+        {100, 0}, {101, 1}, {102, 2}, {103, 3}, {104, 4}, {105, 5}, {106, 6}, {107, 7},
+        {108, 8}, {109, 9}, {110, 10}, {111, 11}, {112, 12}, {113, 13}, {114, 14}, {115, 15},
+        {116, 16}, {117, 17}, {118, 18}, {119, 19}, {120, 20}, {121, 21}, {122, 22}, {123, 23},
+        {124, 24}, {125, 25}, {126, 26}, {127, 27}, {128, 28}, {129, 29}, {130, 30}, {131, 31},
+        {132, 32}, {133, 33}, {134, 34}, {135, 35}, {136, 36}, {137, 37}, {138, 38}, {139, 39},
+        {140, 40}, {141, 41}, {142, 42}, {143, 43}, {144, 44}, {145, 45}, {146, 46}, {147, 47},
+        {148, 48}, {149, 49}, {150, 50}, {151, 51}, {152, 52}, {153, 53}, {154, 54}, {155, 55},
+        {156, 56}, {157, 57}, {158, 58}, {159, 59}, {160, 60}, {161, 61}, {162, 62}, {163, 63}
+    });
+    static_assert(testTable.bucketCount() == 64);
+    static_assert(*testTable.get(163) == 63);
+
+    bool allFound = true;
+    for (int i = 0; i < 64; i++) allFound = allFound && testTable.get(100 + i) != nullptr && *testTable.get(100 + i) == i;
+    REQUIRE(allFound);
+    REQUIRE(testTable.contains(99) == false);
+    REQUIRE(testTable.contains(164) == false);
+}
+
+struct StaticHashTableTestConstantHash
+{
+    constexpr size_t operator()(int) const
+    {
+        return 42;
+    }
+};
+
+TEST_CASE("Static hash table rejects a hash that cannot tell its keys apart", "[StaticHashTable]")
+{
+    // At compile time this throw is the compile error
+    const std::pair<int, int> elements[] = {{1, 1}, {2, 2}, {3, 3}};
+    REQUIRE_THROWS_AS((StaticHashTable<int, int, 3, StaticHashTableTestConstantHash>(elements)), std::overflow_error);
+
+    const std::pair<int, int> duplicates[] = {{1, 1}, {1, 2}};
+    REQUIRE_THROWS_AS((StaticHashTable<int, int, 2>(duplicates)), std::invalid_argument);
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2023 Jacob Hunt
+ *
+ * @file SwissHashTableTests.cpp
+ * @brief Unit tests for a Swiss table style hash table implementation of a key/value dictionary
+ * @author Jacob Hunt
+ * @copyright MIT License
+ * Contact: (jacobhuntdevelopment@gmail.com)
+ */
+
+#include "../../Libraries/Catch2/catch.hpp"
+#include "../SwissHashTable.hpp"
+#include <vector>
+
+TEST_CASE("Swiss table grows to hold many elements", "[SwissHashTable][insert()]")
+{
+    SwissHashTable<std::string, int> testTable;
+    for (int i = 0; i < 5000; i++) testTable.insert(std::to_string(i), i);
+
+    bool allFound = true;
+    for (int i = 0; i < 5000; i++) allFound = allFound && *testTable.get(std::to_string(i)) == i;
+
+    REQUIRE(testTable.size() == 5000);
+    REQUIRE(allFound);
+    REQUIRE(testTable.loadFactor() <= 0.875f);
+}
+
+TEST_CASE("Swiss table remove behaves as expected", "[SwissHashTable][remove()]")
+{
+    SwissHashTable<int, int> testTable;
+    for (int i = 0; i < 1000; i++) testTable.insert(i, i);
+
+    SECTION("Removing keys leaves every other key reachable")
+    {
+        for (int i = 0; i < 1000; i += 2) REQUIRE(testTable.remove(i) == true);
+
+        bool remainingFound = true;
+        bool removedMissing = true;
+        for (int i = 0; i < 1000; i++)
+        {
+            if (i % 2 == 0) removedMissing = removedMissing && !testTable.contains(i);
+            else remainingFound = remainingFound && *testTable.get(i) == i;
+        }
+        REQUIRE(testTable.size() == 500);
+        REQUIRE(remainingFound);
+        REQUIRE(removedMissing);
+    }
+
+    SECTION("Repeatedly inserting and removing keys does not grow the table")
+    {
+        size_t bucketCount = testTable.bucketCount();
+        for (int i = 1000; i < 100000; i++)
+        {
+            testTable.insert(i, i);
+            testTable.remove(i - 1000);
+        }
+        REQUIRE(testTable.size() == 1000);
+        REQUIRE(testTable.bucketCount() == bucketCount);
+        REQUIRE(*testTable.get(99999) == 99999);
+    }
+
+    SECTION("Removing a key that does not exist returns false")
+    {
+        REQUIRE(testTable.remove(5000) == false);
+    }
+}
+
+// Starts the probe sequence of every key at the last group, and stores the
+// low bits of the key in its control byte
+struct SwissHashTableTestLastGroupHash
+{
+    size_t operator()(int key) const
+    {
+        return ~(size_t)0 << 7 | ((size_t)key & 0x7F);
+    }
+};
+
+TEST_CASE("Swiss table probes wrap around from the last group and pass tombstones", "[SwissHashTable][insert()][remove()]")
+{
+    SwissHashTable<int, int, SwissHashTableTestLastGroupHash> testTable(128);
+    const int width = (int)SwissHashTableGroup::WIDTH;
+
+    // The last group fills, and the rest of the keys wrap around to the first group
+    for (int i = 0; i < width + 4; i++) testTable.insert(i, i);
+
+    bool allFound = true;
+    for (int i = 0; i < width + 4; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+    REQUIRE(testTable.bucketCount() == 128);
+    REQUIRE(allFound);
+    REQUIRE(testTable.contains(width + 4) == false);
+
+    SECTION("Removing a key from the full last group leaves keys in the first group reachable")
+    {
+        REQUIRE(testTable.remove(0) == true);
+        REQUIRE(testTable.contains(0) == false);
+
+        bool restFound = true;
+        for (int i = 1; i < width + 4; i++) restFound = restFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+        REQUIRE(restFound);
+    }
+
+    SECTION("Deleted slots in the last group are reused without growing the table")
+    {
+        // The last group never has an empty slot, so each removal leaves a
+        // tombstone there, and the next insert fills it
+        std::vector<int> lastGroupKeys;
+        for (int i = 0; i < width; i++) lastGroupKeys.push_back(i);
+        bool removed = true;
+        for (int round = 0; round < 1000; round++)
+        {
+            int& key = lastGroupKeys[round % width];
+            removed = removed && testTable.remove(key);
+            key = 1000 + round;
+            testTable.insert(key, key);
+        }
+
+        bool allFound = true;
+        for (int key : lastGroupKeys) allFound = allFound && testTable.get(key) != nullptr && *testTable.get(key) == key;
+        for (int i = width; i < width + 4; i++) allFound = allFound && testTable.get(i) != nullptr && *testTable.get(i) == i;
+        REQUIRE(removed);
+        REQUIRE(allFound);
+        REQUIRE(testTable.size() == (size_t)width + 4);
+        REQUIRE(testTable.bucketCount() == 128);
+    }
+}
@@ -15,7 +15,22 @@
 #include "../Libraries/Catch2/catch.hpp"
 
 // Include all unit tests for all collections in the project
+#include "../HashTable/Tests/CommonHashTableTests.cpp"
+#include "../HashTable/Tests/CompactHashTableTests.cpp"
+#include "../HashTable/Tests/ConcurrentHashTableTests.cpp"
+#include "../HashTable/Tests/CuckooHashTableTests.cpp"
+#include "../HashTable/Tests/EpochReclaimerTests.cpp"
+#include "../HashTable/Tests/FrozenHashTableTests.cpp"
+#include "../HashTable/Tests/HashFunctionsTests.cpp"
 #include "../HashTable/Tests/HashTableTests.cpp"
+#include "../HashTable/Tests/MappedHashTableTests.cpp"
+#include "../HashTable/Tests/RcuHashTableTests.cpp"
+#include "../HashTable/Tests/RobinHoodHashTableTests.cpp"
+#include "../HashTable/Tests/ShardedHashTableTests.cpp"
+#include "../HashTable/Tests/SlabAllocatorTests.cpp"
+#include "../HashTable/Tests/SplitOrderedHashTableTests.cpp"
+#include "../HashTable/Tests/StaticHashTableTests.cpp"
+#include "../HashTable/Tests/SwissHashTableTests.cpp"
 #include "../RedBlackTree/Tests/ClearTests.cpp"
 #include "../RedBlackTree/Tests/GetTests.cpp"
 #include "../RedBlackTree/Tests/TreePropertiesTests.cpp"